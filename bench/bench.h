@@ -0,0 +1,195 @@
+#pragma once
+
+#ifndef OMTL_BENCH_BENCH_H
+#define OMTL_BENCH_BENCH_H
+
+
+// Minimal self-contained benchmark harness.
+//
+// Benchmarks register themselves with OMTL_BENCHMARK and run their body
+// state.iterations times. The runner calibrates the iteration count to
+// --min-time, keeps the best of --repetitions runs, prints a table and
+// optionally writes JSON (--json=path) for regression tracking.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <omtl/utils/cpu.h>
+
+
+namespace bench {
+
+
+template <class T>
+inline void do_not_optimize (const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+
+struct state {
+  size_t iterations = 1;
+  size_t bytes      = 0;  ///< Bytes processed per iteration, for throughput.
+  size_t items      = 0;  ///< Items processed per iteration, for throughput.
+};
+
+
+struct result {
+  std::string name;
+  size_t      iterations;
+  double      ns_per_iter;
+  double      bytes_per_second;
+  double      items_per_second;
+};
+
+
+struct entry {
+  std::string                  name;
+  std::function<void(state &)> body;
+};
+
+inline std::vector<entry> &registry (void) {
+  static std::vector<entry> benchmarks;
+  return benchmarks;
+}
+
+struct registrar {
+  registrar (const char *name, std::function<void(state &)> body) {
+    registry().push_back({ name, std::move(body) });
+  }
+};
+
+#define OMTL_BENCH_CAT2(_A, _B) _A##_B
+#define OMTL_BENCH_CAT(_A, _B)  OMTL_BENCH_CAT2(_A, _B)
+
+/// @def OMTL_BENCHMARK(_Name, ...)
+///      Registers a callable taking bench::state & under a "group/variant/case" name.
+///      Variadic so that bodies may contain unparenthesized commas.
+#define OMTL_BENCHMARK(_Name, ...) \
+  static const ::bench::registrar OMTL_BENCH_CAT(bench_registrar_, __LINE__)(_Name, __VA_ARGS__)
+
+
+struct options {
+  double      min_time    = 0.2;
+  unsigned    repetitions = 3;
+  std::string filter;
+  std::string json;
+};
+
+inline options parse (int argc, char **argv) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if      (!std::strncmp(arg, "--min-time=",    11)) { opt.min_time    = std::atof(arg + 11); }
+    else if (!std::strncmp(arg, "--repetitions=", 14)) { opt.repetitions = static_cast<unsigned>(std::atoi(arg + 14)); }
+    else if (!std::strncmp(arg, "--filter=",       9)) { opt.filter      = arg + 9; }
+    else if (!std::strncmp(arg, "--json=",         7)) { opt.json        = arg + 7; }
+    else {
+      std::fprintf(stderr, "usage: %s [--min-time=s] [--repetitions=n] [--filter=substr] [--json=path]\n", argv[0]);
+      std::exit(2);
+    }
+  }
+  opt.repetitions = std::max(1u, opt.repetitions);
+  return opt;
+}
+
+
+inline double time_once (const entry &e, state &st) {
+  const auto start = std::chrono::steady_clock::now();
+  e.body(st);
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+inline result measure (const entry &e, const options &opt) {
+  state st;
+  double seconds = time_once(e, st);
+  while (seconds < opt.min_time / 10 && st.iterations < (size_t(1) << 40)) {
+    st.iterations *= seconds > 0 ? std::max<size_t>(2, std::min<size_t>(10, size_t(opt.min_time / 10 / seconds) + 1)) : 10;
+    seconds = time_once(e, st);
+  }
+  st.iterations = std::max<size_t>(1, size_t(double(st.iterations) * opt.min_time / std::max(seconds, 1e-9)));
+
+  double best = time_once(e, st);
+  for (unsigned r = 1; r < opt.repetitions; ++r) {
+    best = std::min(best, time_once(e, st));
+  }
+  const double iters = double(st.iterations);
+  return { e.name, st.iterations, best * 1e9 / iters, double(st.bytes) * iters / best, double(st.items) * iters / best };
+}
+
+
+inline const char *simd_level (void) {
+  using omtl::cpu::feature;
+#ifdef OMTL_SIMD_X86
+  if (omtl::cpu::supports(feature::avx2))  { return "avx2";  }
+  if (omtl::cpu::supports(feature::ssse3)) { return "ssse3"; }
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+inline void print (const result &r) {
+  std::printf("%-52s %14.1f ns %12zu it", r.name.c_str(), r.ns_per_iter, r.iterations);
+  if (r.bytes_per_second > 0) { std::printf(" %10.1f MB/s", r.bytes_per_second / 1e6); }
+  if (r.items_per_second > 0) { std::printf(" %10.2f M/s", r.items_per_second / 1e6); }
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+inline bool write_json (const std::string &path, const char *suite, const std::vector<result> &results) {
+  std::FILE *out = std::fopen(path.c_str(), "w");
+  if (!out) { return false; }
+  std::fprintf(out, "{\n  \"context\": {\"suite\": \"%s\", \"simd\": \"%s\", \"compiler\": \"%s\"},\n  \"benchmarks\": [\n",
+               suite, simd_level(),
+#if defined(__clang__)
+               "clang " __clang_version__
+#elif defined(__GNUC__)
+               "gcc " __VERSION__
+#else
+               "unknown"
+#endif
+               );
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result &r = results[i];
+    std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_iter\": %.3f, "
+                      "\"bytes_per_second\": %.1f, \"items_per_second\": %.1f}%s\n",
+                 r.name.c_str(), r.iterations, r.ns_per_iter, r.bytes_per_second, r.items_per_second,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(out, "  ]\n}\n");
+  return std::fclose(out) == 0;
+}
+
+/// @brief Runs every registered benchmark matching --filter.
+inline int run (int argc, char **argv, const char *suite) {
+  const options opt = parse(argc, argv);
+  std::vector<result> results;
+  std::printf("# %s (simd: %s)\n", suite, simd_level());
+  for (const entry &e : registry()) {
+    if (!opt.filter.empty() && e.name.find(opt.filter) == std::string::npos) { continue; }
+    results.push_back(measure(e, opt));
+    print(results.back());
+  }
+  if (!opt.json.empty() && !write_json(opt.json, suite, results)) {
+    std::fprintf(stderr, "cannot write %s\n", opt.json.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+
+}  // namespace bench
+
+#endif  // OMTL_BENCH_BENCH_H
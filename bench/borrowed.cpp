@@ -0,0 +1,88 @@
+// Cost of borrowed pointers. Built twice: omtl_bench_borrowed uses the
+// release borrowed (a raw pointer), omtl_bench_borrowed_debug defines
+// OMTL_DEBUG_BORROWED_PTR, so the two outputs give the checking overhead.
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_borrowed omtl_bench_borrowed_debug
+//   build/bench/omtl_bench_borrowed_debug [--json=borrowed_debug.json]
+
+#include <cstdint>
+#include <vector>
+
+#include <omtl/memory.h>
+
+#include "bench.h"
+#include "corpus.h"
+
+
+namespace {
+
+struct node {
+  uint64_t value;
+  uint64_t pad[3];
+};
+
+constexpr size_t object_count = 4096;
+
+
+struct objects {
+  objects (void) {
+    for (size_t i = 0; i < object_count; ++i) { owned.push_back(omtl::owner<node>::make(node{ i, { } })); }
+    bench::rng r;
+    for (size_t i = 0; i < object_count; ++i) { borrows.push_back(owned[r.below(object_count)].borrow()); }
+  }
+
+  std::vector<omtl::owner<node>>    owned;
+  std::vector<omtl::borrowed<node>> borrows;
+};
+
+OMTL_BENCHMARK("deref/raw_pointer", [] (bench::state &st) {
+  objects o;
+  std::vector<node *> raw;
+  for (const auto &b : o.borrows) { raw.push_back(&*b); }
+  st.items = raw.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    uint64_t sum = 0;
+    for (node *p : raw) { sum += p->value; }
+    bench::do_not_optimize(sum);
+  }
+});
+
+OMTL_BENCHMARK("deref/borrowed", [] (bench::state &st) {
+  objects o;
+  st.items = o.borrows.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    uint64_t sum = 0;
+    for (const auto &b : o.borrows) { sum += b->value; }
+    bench::do_not_optimize(sum);
+  }
+});
+
+OMTL_BENCHMARK("borrow/first", [] (bench::state &st) {
+  st.items = object_count;
+  std::vector<omtl::owner<node>> owned;
+  for (size_t i = 0; i < object_count; ++i) { owned.push_back(omtl::owner<node>::make(node{ i, { } })); }
+  for (size_t i = 0; i < st.iterations; ++i) {
+    // Resetting retires each owner's slot, so every round borrows afresh.
+    for (auto &o : owned) { bench::do_not_optimize(o.borrow()); }
+    for (auto &o : owned) { o.reset(new node{ i, { } }); }
+  }
+});
+
+OMTL_BENCHMARK("borrow/repeated", [] (bench::state &st) {
+  objects o;
+  st.items = o.owned.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const auto &owned : o.owned) { bench::do_not_optimize(owned.borrow()); }
+  }
+});
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+#ifdef OMTL_DEBUG_BORROWED_PTR
+  return bench::run(argc, argv, "borrowed_debug");
+#else
+  return bench::run(argc, argv, "borrowed");
+#endif
+}
@@ -0,0 +1,110 @@
+// Interning throughput of str::concurrent_storage from 1 to N threads,
+// against one storage behind a global mutex and one storage per thread.
+// Thread counts double up to hardware_concurrency(), one benchmark each.
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_concurrent_storage
+//   build/bench/omtl_bench_concurrent_storage [--filter=threads_4] [--json=concurrent_storage.json]
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <omtl/str/concurrent_storage.h>
+
+#include "bench.h"
+
+
+namespace {
+
+using omtl::str::basic_view;
+using view = basic_view<char>;
+using pool = omtl::str::storage<char>;
+
+constexpr size_t keys_per_thread = 1 << 20;
+constexpr size_t distinct_keys   = 1 << 16;
+
+
+std::vector<std::string> make_corpus (void) {
+  std::vector<std::string> keys;
+  keys.reserve(distinct_keys);
+  for (size_t i = 0; i < distinct_keys; ++i) {
+    keys.push_back("metric.label." + std::to_string(i * 2654435761u % 1000003));
+  }
+  return keys;
+}
+
+template <class Body>
+void fan_out (unsigned threads, Body body) {
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back(body, t);
+  }
+  for (auto &w : workers) { w.join(); }
+}
+
+view key_at (const std::vector<std::string> &keys, unsigned thread, size_t i) {
+  const std::string &k = keys[(i * 7919 + thread * 104729) % keys.size()];
+  return view(k.data(), k.size());
+}
+
+const std::vector<std::string> &corpus (void) {
+  static const std::vector<std::string> keys = make_corpus();
+  return keys;
+}
+
+const pool::settings_flags flags = pool::settings_flags(pool::settings::intern) | pool::settings::alloc_enable;
+
+/// One iteration interns keys_per_thread keys on each of @p threads
+/// threads into fresh storage.
+void register_sweep (unsigned threads) {
+  const std::string suffix = "/threads_" + std::to_string(threads);
+
+  bench::registry().push_back({ "intern/sharded" + suffix, [threads] (bench::state &st) {
+    st.items = threads * keys_per_thread;
+    for (size_t i = 0; i < st.iterations; ++i) {
+      omtl::str::concurrent_storage<char> shared;
+      fan_out(threads, [&] (unsigned t) {
+        for (size_t k = 0; k < keys_per_thread; ++k) { shared.add(key_at(corpus(), t, k)); }
+      });
+    }
+  } });
+
+  bench::registry().push_back({ "intern/mutex" + suffix, [threads] (bench::state &st) {
+    st.items = threads * keys_per_thread;
+    for (size_t i = 0; i < st.iterations; ++i) {
+      pool       global(4096, flags);
+      std::mutex global_lock;
+      fan_out(threads, [&] (unsigned t) {
+        for (size_t k = 0; k < keys_per_thread; ++k) {
+          std::lock_guard<std::mutex> guard(global_lock);
+          global.add(key_at(corpus(), t, k));
+        }
+      });
+    }
+  } });
+
+  bench::registry().push_back({ "intern/local" + suffix, [threads] (bench::state &st) {
+    st.items = threads * keys_per_thread;
+    for (size_t i = 0; i < st.iterations; ++i) {
+      fan_out(threads, [] (unsigned t) {
+        pool own(4096, flags);
+        for (size_t k = 0; k < keys_per_thread; ++k) { own.add(key_at(corpus(), t, k)); }
+      });
+    }
+  } });
+}
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  const unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+    register_sweep(threads);
+    if (threads == max_threads) { break; }
+  }
+  corpus();
+  return bench::run(argc, argv, "concurrent_storage");
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef OMTL_BENCH_CORPUS_H
+#define OMTL_BENCH_CORPUS_H
+
+
+// Deterministic synthetic corpora: the benchmarks must not depend on
+// files outside the repository, and results must be comparable run to run.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+namespace bench {
+
+
+/// xorshift64*: fast and reproducible across standard libraries.
+class rng {
+public:
+  explicit rng (uint64_t seed = 0x9E3779B97F4A7C15ull) : _s(seed) { }
+
+  uint64_t next (void) {
+    _s ^= _s >> 12; _s ^= _s << 25; _s ^= _s >> 27;
+    return _s * 0x2545F4914F6CDD1Dull;
+  }
+  size_t below (size_t n) { return static_cast<size_t>(next() % n); }
+
+private:
+  uint64_t _s;
+};
+
+
+/// @brief Application log, one event per line, about @p bytes long.
+inline std::string log_text (size_t bytes, uint64_t seed = 1) {
+  static const char *levels[]  = { "INFO ", "DEBUG", "WARN ", "ERROR" };
+  static const char *methods[] = { "GET", "POST", "PUT", "DELETE" };
+  static const char *paths[]   = { "/api/v1/items", "/api/v1/users", "/healthz", "/api/v2/orders/search" };
+  rng r(seed);
+  std::string out;
+  char line[256];
+  while (out.size() < bytes) {
+    const int n = std::snprintf(line, sizeof(line),
+      "2024-03-%02zuT%02zu:%02zu:%02zu.%03zuZ %s [worker-%zu] request_id=%08llx method=%s path=%s/%zu "
+      "status=%zu latency_ms=%zu user_agent=\"curl/8.%zu\"\n",
+      1 + r.below(28), r.below(24), r.below(60), r.below(60), r.below(1000),
+      levels[r.below(4)], r.below(16), static_cast<unsigned long long>(r.next() & 0xFFFFFFFFu),
+      methods[r.below(4)], paths[r.below(4)], r.below(100000),
+      r.below(8) ? size_t(200) : size_t(500 + r.below(4)), r.below(2000), r.below(10));
+    out.append(line, static_cast<size_t>(n));
+  }
+  return out;
+}
+
+
+/// @brief CSV rows with a fixed eight-column schema, without header.
+inline std::vector<std::string> csv_rows (size_t count, uint64_t seed = 2) {
+  static const char *categories[] = { "books", "garden", "electronics", "toys", "grocery" };
+  rng r(seed);
+  std::vector<std::string> rows;
+  char line[256];
+  for (size_t i = 0; i < count; ++i) {
+    const int n = std::snprintf(line, sizeof(line), "%zu,item-%zu,%zu.%02zu,%zu,%s,%s,%zu,%s",
+      i, r.below(1000000), r.below(500), r.below(100), r.below(50), categories[r.below(5)],
+      r.below(3) ? "in_stock" : "", 1700000000 + r.below(10000000), r.below(2) ? "true" : "false");
+    rows.emplace_back(line, static_cast<size_t>(n));
+  }
+  return rows;
+}
+
+
+/// @brief Metric / label style identifiers, 4 to ~40 characters, with
+///        @p distinct different values repeated to @p count entries.
+inline std::vector<std::string> identifiers (size_t count, size_t distinct, uint64_t seed = 3) {
+  static const char *parts[] = { "http", "requests", "total", "latency", "bucket", "service", "region",
+                                 "eu", "west", "pod", "cpu", "seconds", "bytes", "rx", "tx", "db" };
+  rng r(seed);
+  std::vector<std::string> pool;
+  for (size_t i = 0; i < distinct; ++i) {
+    std::string id = parts[r.below(16)];
+    for (size_t k = r.below(4); k > 0; --k) { id += '_'; id += parts[r.below(16)]; }
+    id += '_' + std::to_string(i);
+    pool.push_back(id);
+  }
+  std::vector<std::string> out;
+  for (size_t i = 0; i < count; ++i) { out.push_back(pool[r.below(distinct)]); }
+  return out;
+}
+
+
+/// @brief Identifiers surrounded by a few spaces and tabs, for trimming.
+inline std::vector<std::string> padded (const std::vector<std::string> &ids, uint64_t seed = 4) {
+  static const char pad[] = " \t  \t ";
+  rng r(seed);
+  std::vector<std::string> out;
+  for (const std::string &id : ids) {
+    out.push_back(std::string(pad, r.below(6)) + id + std::string(pad, r.below(6)));
+  }
+  return out;
+}
+
+/// @brief User-submitted text in UTF-8, about @p bytes long: words of
+///        Latin, Cyrillic, Greek, CJK and emoji, so 1- to 4-byte sequences
+///        mix; @p ascii_percent of the words are plain ASCII.
+inline std::string utf8_text (size_t bytes, size_t ascii_percent, uint64_t seed = 5) {
+  static const char *ascii[] = { "order", "shipped", "to", "the", "warehouse", "in", "Berlin", "#4521:" };
+  static const char *other[] = {
+    "\xd0\xb7\xd0\xb0\xd0\xba\xd0\xb0\xd0\xb7",                     // Cyrillic
+    "\xce\xb1\xcf\x80\xce\xbf\xce\xb8\xce\xae\xce\xba\xce\xb7",     // Greek
+    "\xe6\x9d\xb1\xe4\xba\xac\xe9\x83\xbd",                         // CJK
+    "caf\xc3\xa9",                                                  // Latin-1
+    "\xf0\x9f\x93\xa6\xf0\x9f\x9a\x9a",                             // emoji
+    "M\xc3\xbcnchen",                                               // Latin-1
+  };
+  rng r(seed);
+  std::string out;
+  while (out.size() < bytes) {
+    out += r.below(100) < ascii_percent ? ascii[r.below(8)] : other[r.below(6)];
+    out += r.below(12) ? ' ' : '\n';
+  }
+  return out;
+}
+
+
+/// @brief Decimal integers of @p min_digits to @p max_digits digits, an
+///        eighth of them negative, e.g. quantities or 64-bit ids.
+inline std::vector<std::string> integers (size_t count, unsigned min_digits, unsigned max_digits, uint64_t seed = 6) {
+  rng r(seed);
+  std::vector<std::string> out;
+  for (size_t i = 0; i < count; ++i) {
+    std::string n = r.below(8) ? "" : "-";
+    const size_t digits = min_digits + r.below(max_digits - min_digits + 1);
+    n += static_cast<char>('1' + r.below(9));
+    while (n.size() < digits + (n[0] == '-')) { n += static_cast<char>('0' + r.below(10)); }
+    out.push_back(std::move(n));
+  }
+  return out;
+}
+
+
+/// @brief Prices, ratios and latencies: 1 to 6 integer digits and 1 to 4
+///        decimals, a few with an exponent.
+inline std::vector<std::string> decimals (size_t count, uint64_t seed = 7) {
+  rng r(seed);
+  std::vector<std::string> out;
+  char text[64];
+  for (size_t i = 0; i < count; ++i) {
+    static const unsigned scale[] = { 10, 100, 1000, 10000 };
+    const unsigned places = static_cast<unsigned>(1 + r.below(4));
+    const int n = std::snprintf(text, sizeof(text), "%zu.%0*zu%s", r.below(1000000), static_cast<int>(places),
+      r.below(scale[places - 1]), r.below(16) ? "" : "e-3");
+    out.emplace_back(text, static_cast<size_t>(n));
+  }
+  return out;
+}
+
+
+}  // namespace bench
+
+#endif  // OMTL_BENCH_CORPUS_H
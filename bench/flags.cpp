@@ -0,0 +1,156 @@
+// flags against std::bitset, and atomic_flags against a compare-exchange
+// loop. The static_asserts pin down the storage size and constexpr use;
+// the benchmarks cover the per-packet pattern of testing a handful of
+// flags, and iterating over the set ones.
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <omtl/utils/flags.h>
+
+#include "bench.h"
+
+
+namespace {
+
+enum class packet_flag : uint8_t {
+  syn, ack, fin, rst, psh, urg, ece, cwr,
+
+  __SENTINEL__
+};
+
+enum class wide_flag {
+  f0, f1, f2, f3, f4, f5, f6, f7, f8,
+
+  __SENTINEL__
+};
+
+using packet_flags = omtl::flags<packet_flag>;
+
+static_assert(sizeof(packet_flags) == 1, "8 enumerators fit in a byte");
+static_assert(sizeof(omtl::flags<wide_flag>) == 2, "9 enumerators take two bytes");
+static_assert(std::is_trivially_copyable<packet_flags>::value, "copied as a plain integer");
+static_assert(omtl::atomic_flags<packet_flag>::is_always_lock_free, "lock-free updates");
+
+constexpr packet_flags handshake = packet_flags(packet_flag::syn) | packet_flag::ack;
+static_assert(handshake.test(packet_flag::ack) && !handshake.test(packet_flag::fin), "constexpr test");
+static_assert(handshake.count() == 2 && (~handshake).count() == 6, "constexpr popcount and complement");
+static_assert(*handshake.begin() == packet_flag::syn, "constexpr iteration");
+
+
+struct packet {
+  uint32_t     seq;
+  packet_flags flags;
+};
+
+struct packet_bitset {
+  uint32_t        seq;
+  std::bitset<8>  flags;
+};
+
+constexpr size_t packet_count = 4096;
+
+template <class P, class Set>
+std::vector<P> make_packets (Set set) {
+  std::vector<P> packets(packet_count);
+  for (size_t i = 0; i < packet_count; ++i) {
+    packets[i].seq = static_cast<uint32_t>(i);
+    const uint32_t r = static_cast<uint32_t>(i * 2654435761u) >> 24;
+    for (unsigned b = 0; b < 8; ++b) {
+      if (r & (1u << b)) { set(packets[i], static_cast<packet_flag>(b)); }
+    }
+  }
+  return packets;
+}
+
+
+OMTL_BENCHMARK("test/bitset", [] (bench::state &st) {
+  auto packets = make_packets<packet_bitset>([] (packet_bitset &p, packet_flag f) { p.flags.set(static_cast<size_t>(f)); });
+  st.items = packet_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t n = 0;
+    for (const auto &p : packets) { n += (p.flags & std::bitset<8>(0x3)).any() && !p.flags.test(2); }
+    bench::do_not_optimize(n);
+  }
+});
+OMTL_BENCHMARK("test/flags", [] (bench::state &st) {
+  auto packets = make_packets<packet>([] (packet &p, packet_flag f) { p.flags.set(f); });
+  st.items = packet_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t n = 0;
+    for (const auto &p : packets) { n += (p.flags & handshake).any() && !p.flags.test(packet_flag::fin); }
+    bench::do_not_optimize(n);
+  }
+});
+
+OMTL_BENCHMARK("iterate/bitset", [] (bench::state &st) {
+  auto packets = make_packets<packet_bitset>([] (packet_bitset &p, packet_flag f) { p.flags.set(static_cast<size_t>(f)); });
+  st.items = packet_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t sum = 0;
+    for (const auto &p : packets) {
+      for (size_t b = 0; b < p.flags.size(); ++b) { if (p.flags.test(b)) { sum += b; } }
+    }
+    bench::do_not_optimize(sum);
+  }
+});
+OMTL_BENCHMARK("iterate/flags", [] (bench::state &st) {
+  auto packets = make_packets<packet>([] (packet &p, packet_flag f) { p.flags.set(f); });
+  st.items = packet_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t sum = 0;
+    for (const auto &p : packets) {
+      for (packet_flag f : p.flags) { sum += static_cast<size_t>(f); }
+    }
+    bench::do_not_optimize(sum);
+  }
+});
+
+
+constexpr size_t thread_count = 4;
+constexpr size_t toggles      = 1 << 14;
+
+OMTL_BENCHMARK("atomic/cas_loop", [] (bench::state &st) {
+  st.items = thread_count * toggles;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    std::atomic<uint8_t> shared{ 0 };
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&shared, t] {
+        const uint8_t bit = static_cast<uint8_t>(1u << t);
+        for (size_t k = 0; k < toggles; ++k) {
+          uint8_t cur = shared.load(std::memory_order_relaxed);
+          while (!shared.compare_exchange_weak(cur, static_cast<uint8_t>(cur ^ bit), std::memory_order_relaxed)) { }
+        }
+      });
+    }
+    for (auto &th : threads) { th.join(); }
+    bench::do_not_optimize(shared.load());
+  }
+});
+OMTL_BENCHMARK("atomic/atomic_flags", [] (bench::state &st) {
+  st.items = thread_count * toggles;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    omtl::atomic_flags<packet_flag> shared;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&shared, t] {
+        const packet_flags bit(static_cast<packet_flag>(t));
+        for (size_t k = 0; k < toggles; ++k) { shared.fetch_xor(bit, std::memory_order_relaxed); }
+      });
+    }
+    for (auto &th : threads) { th.join(); }
+    bench::do_not_optimize(shared.load());
+  }
+});
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  return bench::run(argc, argv, "flags");
+}
@@ -0,0 +1,135 @@
+// not_null against raw pointers. The static_asserts pin down the layout
+// and ABI properties that make not_null free; the benchmarks and the
+// exported sum_* functions show the generated code is the same:
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_not_null
+//   objdump -d --no-show-raw-insn build/bench/omtl_bench_not_null | awk '/<sum_/,/ret/'
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <omtl/memory.h>
+
+#include "bench.h"
+
+
+namespace {
+
+struct node {
+  uint64_t value;
+  node    *next;
+};
+
+using nn_node = omtl::not_null<const node *>;
+
+static_assert(sizeof(nn_node) == sizeof(const node *), "no extra state");
+static_assert(std::is_trivially_copyable<nn_node>::value, "passed in registers, like the raw pointer");
+static_assert(std::is_trivially_destructible<nn_node>::value, "no destructor to run");
+static_assert(std::is_nothrow_constructible<nn_node, const nn_node &>::value, "copies are not re-checked");
+
+constexpr node terminal{ 42, nullptr };
+constexpr nn_node constant(&terminal);
+static_assert(constant->value == 42, "constexpr construction and access");
+
+}  // namespace
+
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define OMTL_BENCH_NOINLINE __attribute__((noinline))
+#else
+#  define OMTL_BENCH_NOINLINE __declspec(noinline)
+#endif
+
+// Not static, so they show up by name in the disassembly.
+extern "C" OMTL_BENCH_NOINLINE uint64_t sum_raw (const node *const *items, size_t n) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < n; ++i) { sum += items[i]->value; }
+  return sum;
+}
+
+extern "C" OMTL_BENCH_NOINLINE uint64_t sum_not_null (const nn_node *items, size_t n) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < n; ++i) { sum += items[i]->value; }
+  return sum;
+}
+
+extern "C" OMTL_BENCH_NOINLINE uint64_t walk_raw (const node *head) {
+  uint64_t sum = 0;
+  for (; head; head = head->next) { sum += head->value; }
+  return sum;
+}
+
+extern "C" OMTL_BENCH_NOINLINE uint64_t walk_not_null (nn_node head) {
+  uint64_t sum = head->value;
+  for (const node *n = head->next; n; n = n->next) { sum += n->value; }
+  return sum;
+}
+
+
+namespace {
+
+constexpr size_t node_count = 4096;
+
+struct graph {
+  graph (void) : nodes(node_count) {
+    for (size_t i = 0; i < node_count; ++i) {
+      nodes[i] = { i, i + 1 < node_count ? &nodes[i + 1] : nullptr };
+      raw.push_back(&nodes[(i * 2654435761u) % node_count]);
+      checked.push_back(nn_node(raw.back()));
+    }
+  }
+
+  std::vector<node>          nodes;
+  std::vector<const node *>  raw;
+  std::vector<nn_node>       checked;
+};
+
+OMTL_BENCHMARK("deref/raw", [] (bench::state &st) {
+  graph g;
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(sum_raw(g.raw.data(), g.raw.size())); }
+});
+OMTL_BENCHMARK("deref/not_null", [] (bench::state &st) {
+  graph g;
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(sum_not_null(g.checked.data(), g.checked.size())); }
+});
+
+OMTL_BENCHMARK("walk/raw", [] (bench::state &st) {
+  graph g;
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(walk_raw(&g.nodes[0])); }
+});
+OMTL_BENCHMARK("walk/not_null", [] (bench::state &st) {
+  graph g;
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(walk_not_null(nn_node(&g.nodes[0]))); }
+});
+
+OMTL_BENCHMARK("convert/not_null_copy", [] (bench::state &st) {
+  graph g;
+  std::vector<omtl::not_null<const node *, omtl::null_throw>> out(node_count, nn_node(&terminal));
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    // Converting between policies copies the pointer without a check.
+    for (size_t k = 0; k < node_count; ++k) { out[k] = g.checked[k]; }
+    bench::do_not_optimize(out.back());
+  }
+});
+OMTL_BENCHMARK("convert/from_raw_throw", [] (bench::state &st) {
+  graph g;
+  std::vector<omtl::not_null<const node *, omtl::null_throw>> out(node_count, nn_node(&terminal));
+  st.items = node_count;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (size_t k = 0; k < node_count; ++k) { out[k] = g.raw[k]; }
+    bench::do_not_optimize(out.back());
+  }
+});
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  return bench::run(argc, argv, "not_null");
+}
@@ -0,0 +1,182 @@
+// Allocation cost of short-lived owned objects: new/delete, std::unique_ptr
+// and mem::owner on the heap, against object_pool and arena allocation, and
+// the construction cost of owner::make, allocate_owner and make_trailing.
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_owner
+//   build/bench/omtl_bench_owner [--filter=churn/] [--json=owner.json]
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <omtl/memory.h>
+
+#include "bench.h"
+#include "corpus.h"
+
+
+namespace {
+
+struct message {
+  message(uint64_t i, uint32_t k) : id(i), kind(k) { payload[0] = static_cast<char>(k); }
+
+  uint64_t id;
+  uint32_t kind;
+  char     payload[44];
+};
+
+#ifndef OMTL_DEBUG_BORROWED_PTR
+static_assert(sizeof(omtl::owner<message>) == sizeof(void *), "stateless deleters take no space");
+static_assert(sizeof(omtl::arena::owner_type<message>) == sizeof(void *), "arena owners are pointer-sized");
+#endif
+
+constexpr size_t live_objects = 4096;
+constexpr size_t steps        = 4096;
+
+
+/// Replaces a random live object per step, the way a message queue or an
+/// object cache churns.
+template <class Make>
+void churn (bench::state &st, Make make) {
+  using handle = decltype(make(0));
+  std::vector<handle> live;
+  for (size_t i = 0; i < live_objects; ++i) { live.push_back(make(i)); }
+
+  st.items = steps;
+  bench::rng r;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (size_t s = 0; s < steps; ++s) {
+      handle &slot = live[r.below(live_objects)];
+      slot = make(s);
+      bench::do_not_optimize(slot);
+    }
+  }
+}
+
+/// Builds a batch of objects and drops all of them, the way a request or
+/// a frame allocates scratch objects.
+template <class Make, class Release>
+void batch (bench::state &st, Make make, Release release) {
+  using handle = decltype(make(0));
+  std::vector<handle> live;
+  live.reserve(steps);
+
+  st.items = steps;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (size_t s = 0; s < steps; ++s) { live.push_back(make(s)); }
+    bench::do_not_optimize(live.back());
+    live.clear();
+    release();
+  }
+}
+
+void nothing (void) { }
+
+
+struct raw_ptr {
+  raw_ptr (message *m = nullptr) : p(m) { }
+  raw_ptr (raw_ptr &&o) noexcept : p(o.p) { o.p = nullptr; }
+  raw_ptr &operator= (raw_ptr &&o) noexcept { delete p; p = o.p; o.p = nullptr; return *this; }
+  ~raw_ptr (void) { delete p; }
+  message *p;
+};
+
+OMTL_BENCHMARK("churn/new_delete", [] (bench::state &st) {
+  churn(st, [] (size_t i) { return raw_ptr(new message(i, 1)); });
+});
+OMTL_BENCHMARK("churn/std_unique_ptr", [] (bench::state &st) {
+  churn(st, [] (size_t i) { return std::make_unique<message>(i, 1); });
+});
+OMTL_BENCHMARK("churn/owner", [] (bench::state &st) {
+  churn(st, [] (size_t i) { return omtl::owner<message>::make(i, 1u); });
+});
+OMTL_BENCHMARK("churn/object_pool", [] (bench::state &st) {
+  omtl::object_pool<message> pool;
+  churn(st, [&pool] (size_t i) { return pool.make(i, 1u); });
+});
+
+OMTL_BENCHMARK("batch/new_delete", [] (bench::state &st) {
+  batch(st, [] (size_t i) { return raw_ptr(new message(i, 2)); }, nothing);
+});
+OMTL_BENCHMARK("batch/std_unique_ptr", [] (bench::state &st) {
+  batch(st, [] (size_t i) { return std::make_unique<message>(i, 2); }, nothing);
+});
+OMTL_BENCHMARK("batch/owner", [] (bench::state &st) {
+  batch(st, [] (size_t i) { return omtl::owner<message>::make(i, 2u); }, nothing);
+});
+OMTL_BENCHMARK("batch/object_pool", [] (bench::state &st) {
+  omtl::object_pool<message> pool;
+  batch(st, [&pool] (size_t i) { return pool.make(i, 2u); }, nothing);
+});
+OMTL_BENCHMARK("batch/arena", [] (bench::state &st) {
+  omtl::arena scratch;
+  batch(st, [&scratch] (size_t i) { return scratch.make<message>(i, 2u); }, [&scratch] { scratch.clear(); });
+});
+
+
+struct record {
+  record(std::string n, std::vector<int> v) : name(std::move(n)), values(std::move(v)) { }
+
+  std::string      name;
+  std::vector<int> values;
+};
+
+/// What owner::make did before it forwarded: arguments taken by value,
+/// then copied again into the constructor.
+template <class T, class ...Args>
+omtl::owner<T> make_by_value (Args ...args) { return omtl::owner<T>(new T(args...)); }
+
+const std::string      record_name = "service.http.requests.latency_bucket{region=eu-west}";
+const std::vector<int> record_values(16, 7);
+
+OMTL_BENCHMARK("make/owner_by_value", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(make_by_value<record>(record_name, record_values)); }
+});
+OMTL_BENCHMARK("make/owner_forward", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(omtl::owner<record>::make(record_name, record_values)); }
+});
+OMTL_BENCHMARK("make/std_make_unique", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(std::make_unique<record>(record_name, record_values)); }
+});
+OMTL_BENCHMARK("make/allocate_owner", [] (bench::state &st) {
+  st.items = 1;
+  const std::allocator<record> alloc;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(omtl::allocate_owner<record>(alloc, record_name, record_values));
+  }
+});
+
+
+/// Name stored after the node in the same allocation.
+struct name_node {
+  explicit name_node(size_t n) : length(n) { }
+
+  size_t length;
+};
+
+OMTL_BENCHMARK("make_named/owner_std_string", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(omtl::owner<std::string>::make(record_name));
+  }
+});
+OMTL_BENCHMARK("make_named/make_trailing", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    auto node = omtl::make_trailing<name_node, char>(record_name.size(), record_name.size());
+    std::memcpy(omtl::trailing_data<char>(node.get()), record_name.data(), record_name.size());
+    bench::do_not_optimize(node);
+  }
+});
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  return bench::run(argc, argv, "owner");
+}
@@ -0,0 +1,88 @@
+// Sharing cost: std::shared_ptr against the intrusive mem::shared with the
+// atomic and the thread-local reference count policies.
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_shared
+//   build/bench/omtl_bench_shared [--json=shared.json]
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <omtl/memory.h>
+
+#include "bench.h"
+
+
+namespace {
+
+struct plain_message {
+  uint64_t id;
+  uint32_t kind;
+  char     payload[44];
+};
+
+struct atomic_message : omtl::ref_counted<atomic_message> {
+  uint64_t id;
+  uint32_t kind;
+  char     payload[44];
+};
+
+struct local_message : omtl::ref_counted<local_message, omtl::local_refcount> {
+  uint64_t id;
+  uint32_t kind;
+  char     payload[44];
+};
+
+static_assert(sizeof(atomic_message) <= 64 && sizeof(local_message) <= 64, "one cache line with the count");
+
+constexpr size_t fan_out = 1024;
+
+
+/// Hands one object to many holders and drops them again, the way an
+/// event is queued to several subscribers.
+template <class Ptr>
+void fan (bench::state &st, const Ptr &source) {
+  std::vector<Ptr> holders(fan_out);
+  st.items = fan_out;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (Ptr &h : holders) { h = source; }
+    bench::do_not_optimize(holders.back());
+    for (Ptr &h : holders) { h = Ptr(); }
+  }
+}
+
+OMTL_BENCHMARK("copy/std_shared_ptr",  [] (bench::state &st) { fan(st, std::make_shared<plain_message>()); });
+OMTL_BENCHMARK("copy/shared_atomic",   [] (bench::state &st) { fan(st, omtl::shared<atomic_message>::make()); });
+OMTL_BENCHMARK("copy/shared_local",    [] (bench::state &st) { fan(st, omtl::shared<local_message>::make()); });
+
+OMTL_BENCHMARK("make/std_make_shared", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(std::make_shared<plain_message>()); }
+});
+OMTL_BENCHMARK("make/std_shared_ptr_from_unique", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(std::shared_ptr<plain_message>(std::make_unique<plain_message>()));
+  }
+});
+OMTL_BENCHMARK("make/shared_atomic", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(omtl::shared<atomic_message>::make()); }
+});
+OMTL_BENCHMARK("make/shared_from_owner", [] (bench::state &st) {
+  st.items = 1;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(omtl::shared<atomic_message>(omtl::owner<atomic_message>::make()));
+  }
+});
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  // libstdc++ skips the atomics of shared_ptr while a process has never had a
+  // second thread; services always have, so measure that situation.
+  std::thread([] { }).join();
+  return bench::run(argc, argv, "shared");
+}
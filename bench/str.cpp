@@ -0,0 +1,869 @@
+// String subsystem benchmarks: omtl::str::basic_view search, split, line
+// reading, trim, case-insensitive matching, UTF-8, number parsing and
+// formatting, hashing, keyword tables, storage and the owning basic_string,
+// side by side with std::string_view, std::string and the C and C++
+// conversion functions.
+//
+//   cmake -S . -B build && cmake --build build --target omtl_bench_str
+//   build/bench/omtl_bench_str [--filter=find/] [--json=str.json]
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <omtl/string.h>
+
+#include "bench.h"
+#include "corpus.h"
+
+
+namespace {
+
+using view  = omtl::str::basic_view<char>;
+using pool  = omtl::str::storage<char>;
+using flags = pool::settings_flags;
+
+const std::string &events (void) {
+  static const std::string text = bench::log_text(32 * 1024);
+  return text;
+}
+
+const std::vector<std::string> &csv (void) {
+  static const std::vector<std::string> rows = bench::csv_rows(10000);
+  return rows;
+}
+
+const std::vector<std::string> &labels (void) {
+  static const std::vector<std::string> ids = bench::identifiers(100000, 10000);
+  return ids;
+}
+
+const std::vector<std::string> &few_labels (void) {
+  static const std::vector<std::string> ids = bench::identifiers(2000, 500);
+  return ids;
+}
+
+const std::vector<std::string> &padded_labels (void) {
+  static const std::vector<std::string> ids = bench::padded(bench::identifiers(10000, 10000));
+  return ids;
+}
+
+view as_view (const std::string &s) { return view(s.data(), s.size()); }
+
+
+// Needles do not occur in the corpus, so every call scans the whole text.
+const char short_needle[] = "status=404 ";
+const char long_needle[]  = "path=/api/v3/internal/reindex?force=true&shard=7";
+const char delimiters[]   = "<>{}|";
+
+
+template <class Text, class Needle>
+void find_loop (bench::state &st, const Text &text, const Needle &needle) {
+  st.bytes = text.size();
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(text.find(needle)); }
+}
+
+template <class Text, class Needle>
+void rfind_loop (bench::state &st, const Text &text, const Needle &needle) {
+  st.bytes = text.size();
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(text.rfind(needle)); }
+}
+
+template <class Text, class Set>
+void find_first_of_loop (bench::state &st, const Text &text, const Set &set) {
+  st.bytes = text.size();
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(text.find_first_of(set)); }
+}
+
+OMTL_BENCHMARK("find/omtl/log_short",            [] (bench::state &st) { find_loop(st, as_view(events()), view(short_needle)); });
+OMTL_BENCHMARK("find/std_string_view/log_short", [] (bench::state &st) { find_loop(st, std::string_view(events()), std::string_view(short_needle)); });
+OMTL_BENCHMARK("find/std_string/log_short",      [] (bench::state &st) { find_loop(st, events(), std::string(short_needle)); });
+
+OMTL_BENCHMARK("find/omtl/log_long",             [] (bench::state &st) { find_loop(st, as_view(events()), view(long_needle)); });
+OMTL_BENCHMARK("find/std_string_view/log_long",  [] (bench::state &st) { find_loop(st, std::string_view(events()), std::string_view(long_needle)); });
+OMTL_BENCHMARK("find/std_string/log_long",       [] (bench::state &st) { find_loop(st, events(), std::string(long_needle)); });
+
+OMTL_BENCHMARK("find/omtl/log_char",             [] (bench::state &st) { find_loop(st, as_view(events()), '\x01'); });
+OMTL_BENCHMARK("find/std_string_view/log_char",  [] (bench::state &st) { find_loop(st, std::string_view(events()), '\x01'); });
+
+OMTL_BENCHMARK("rfind/omtl/log_short",           [] (bench::state &st) { rfind_loop(st, as_view(events()), view(short_needle)); });
+OMTL_BENCHMARK("rfind/std_string_view/log_short",[] (bench::state &st) { rfind_loop(st, std::string_view(events()), std::string_view(short_needle)); });
+OMTL_BENCHMARK("rfind/std_string/log_short",     [] (bench::state &st) { rfind_loop(st, events(), std::string(short_needle)); });
+
+OMTL_BENCHMARK("rfind/omtl/log_char",            [] (bench::state &st) { rfind_loop(st, as_view(events()), '\x01'); });
+OMTL_BENCHMARK("rfind/std_string_view/log_char", [] (bench::state &st) { rfind_loop(st, std::string_view(events()), '\x01'); });
+
+OMTL_BENCHMARK("find_first_of/omtl/log",         [] (bench::state &st) { find_first_of_loop(st, as_view(events()), view(delimiters)); });
+OMTL_BENCHMARK("find_first_of/omtl_charset/log", [] (bench::state &st) {
+  const omtl::str::charset set(delimiters);
+  find_first_of_loop(st, as_view(events()), set);
+});
+OMTL_BENCHMARK("find_first_of/std_string_view/log", [] (bench::state &st) { find_first_of_loop(st, std::string_view(events()), std::string_view(delimiters)); });
+OMTL_BENCHMARK("find_first_of/std_string/log",      [] (bench::state &st) { find_first_of_loop(st, events(), std::string(delimiters)); });
+
+
+template <class Rows>
+size_t csv_bytes (const Rows &rows) {
+  size_t total = 0;
+  for (const auto &row : rows) { total += row.size(); }
+  return total;
+}
+
+OMTL_BENCHMARK("split/omtl_lazy_char/csv", [] (bench::state &st) {
+  st.bytes = csv_bytes(csv());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      for (view field : omtl::str::lazy_split(as_view(row), ',')) { bench::do_not_optimize(field); }
+    }
+  }
+});
+
+OMTL_BENCHMARK("split/omtl_vector_view/csv", [] (bench::state &st) {
+  st.bytes = csv_bytes(csv());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      bench::do_not_optimize(omtl::str::split<std::vector<view>>(as_view(row), view(",")));
+    }
+  }
+});
+
+OMTL_BENCHMARK("split/std_string_view/csv", [] (bench::state &st) {
+  st.bytes = csv_bytes(csv());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      std::string_view rest(row);
+      for (;;) {
+        const size_t pos = rest.find(',');
+        bench::do_not_optimize(rest.substr(0, pos));
+        if (pos == std::string_view::npos) { break; }
+        rest.remove_prefix(pos + 1);
+      }
+    }
+  }
+});
+
+OMTL_BENCHMARK("split/std_string_getline/csv", [] (bench::state &st) {
+  st.bytes = csv_bytes(csv());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      std::istringstream in(row);
+      std::string field;
+      while (std::getline(in, field, ',')) { bench::do_not_optimize(field); }
+    }
+  }
+});
+
+OMTL_BENCHMARK("split/omtl_lazy_char/log_lines", [] (bench::state &st) {
+  st.bytes = events().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (view line : omtl::str::lazy_split(as_view(events()), '\n')) { bench::do_not_optimize(line); }
+  }
+});
+
+OMTL_BENCHMARK("split/std_string_view/log_lines", [] (bench::state &st) {
+  st.bytes = events().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    std::string_view rest(events());
+    for (size_t pos; (pos = rest.find('\n')) != std::string_view::npos; rest.remove_prefix(pos + 1)) {
+      bench::do_not_optimize(rest.substr(0, pos));
+    }
+  }
+});
+
+
+// A 4 MiB log file, read line by line from disk (the page cache, after the
+// first pass), counting the error lines; the baseline is std::getline.
+const std::string &log_file (void) {
+  static const std::string path = [] {
+    const std::string p = (std::filesystem::temp_directory_path() / "omtl_bench_lines.log").string();
+    std::ofstream(p, std::ios::binary) << bench::log_text(4 * 1024 * 1024);
+    return p;
+  }();
+  return path;
+}
+
+// The level follows the 24-character timestamp and a space.
+size_t is_error (view line) {
+  return line.size() > 25 && omtl::str::starts_with(line.substr(25), view("ERROR"));
+}
+
+template <class Read>
+void lines_loop (bench::state &st, Read read) {
+  st.bytes = std::filesystem::file_size(log_file());
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(read()); }
+}
+
+OMTL_BENCHMARK("lines/omtl_reader_mmap/log_file", [] (bench::state &st) {
+  lines_loop(st, [] {
+    omtl::str::line_reader reader;
+    reader.open(log_file().c_str());
+    size_t errors = 0;
+    for (view line : reader) { errors += is_error(line); }
+    return errors;
+  });
+});
+OMTL_BENCHMARK("lines/omtl_reader_istream/log_file", [] (bench::state &st) {
+  lines_loop(st, [] {
+    std::ifstream in(log_file(), std::ios::binary);
+    omtl::str::line_reader reader;
+    reader.open(in);
+    size_t errors = 0;
+    for (view line : reader) { errors += is_error(line); }
+    return errors;
+  });
+});
+OMTL_BENCHMARK("lines/std_getline/log_file", [] (bench::state &st) {
+  lines_loop(st, [] {
+    std::ifstream in(log_file(), std::ios::binary);
+    std::string line;
+    size_t errors = 0;
+    while (std::getline(in, line)) { errors += is_error(as_view(line)); }
+    return errors;
+  });
+});
+
+OMTL_BENCHMARK("trim/omtl/padded_ids", [] (bench::state &st) {
+  st.items = padded_labels().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &id : padded_labels()) { bench::do_not_optimize(omtl::str::trim(as_view(id))); }
+  }
+});
+
+OMTL_BENCHMARK("trim/std_string_view/padded_ids", [] (bench::state &st) {
+  st.items = padded_labels().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &id : padded_labels()) {
+      std::string_view v(id);
+      v.remove_prefix(std::min(v.find_first_not_of(" \t\n\r"), v.size()));
+      v.remove_suffix(v.size() - (v.find_last_not_of(" \t\n\r") + 1));
+      bench::do_not_optimize(v);
+    }
+  }
+});
+
+
+void add_all (bench::state &st, const std::vector<std::string> &ids, flags f) {
+  st.items = ids.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    pool p(4096, f);
+    for (const std::string &id : ids) { bench::do_not_optimize(p.add(as_view(id))); }
+  }
+}
+
+const flags growing = flags(pool::settings::alloc_enable);
+
+OMTL_BENCHMARK("storage_add/omtl_append/labels",    [] (bench::state &st) { add_all(st, labels(), growing); });
+OMTL_BENCHMARK("storage_add/omtl_intern/labels",    [] (bench::state &st) { add_all(st, labels(), growing | pool::settings::intern); });
+OMTL_BENCHMARK("storage_add/std_unordered_set_string/labels", [] (bench::state &st) {
+  st.items = labels().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    std::unordered_set<std::string> set;
+    for (const std::string &id : labels()) { bench::do_not_optimize(*set.insert(id).first); }
+  }
+});
+OMTL_BENCHMARK("storage_add/std_unordered_set_view/labels", [] (bench::state &st) {
+  st.items = labels().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    std::deque<std::string> owned;
+    std::unordered_set<std::string_view> set;
+    for (const std::string &id : labels()) {
+      auto found = set.find(id);
+      if (found == set.end()) {
+        owned.push_back(id);
+        found = set.insert(owned.back()).first;
+      }
+      bench::do_not_optimize(*found);
+    }
+  }
+});
+
+// The substring-sharing scan is quadratic, so it only gets the small corpus.
+OMTL_BENCHMARK("storage_add/omtl_intern/few_labels",       [] (bench::state &st) { add_all(st, few_labels(), growing | pool::settings::intern); });
+OMTL_BENCHMARK("storage_add/omtl_mem_optimize/few_labels", [] (bench::state &st) { add_all(st, few_labels(), growing | pool::settings::mem_optimize); });
+OMTL_BENCHMARK("storage_add/omtl_intern_mem_optimize/few_labels", [] (bench::state &st) {
+  add_all(st, few_labels(), growing | pool::settings::intern | pool::settings::mem_optimize);
+});
+
+
+
+template <class Hash, class Keys>
+void hash_loop (bench::state &st, const Keys &keys, Hash h) {
+  size_t bytes = 0;
+  for (const auto &k : keys) { bytes += k.size(); }
+  st.bytes = bytes;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t acc = 0;
+    for (const auto &k : keys) { acc ^= h(k); }
+    bench::do_not_optimize(acc);
+  }
+}
+
+const std::vector<std::string> &log_chunks (void) {
+  static const std::vector<std::string> chunks = [] {
+    std::vector<std::string> out;
+    for (size_t at = 0; at + 4096 <= events().size(); at += 4096) { out.push_back(events().substr(at, 4096)); }
+    return out;
+  }();
+  return chunks;
+}
+
+OMTL_BENCHMARK("hash/omtl/labels",            [] (bench::state &st) { hash_loop(st, labels(), omtl::str::hash()); });
+OMTL_BENCHMARK("hash/std_string_view/labels", [] (bench::state &st) {
+  hash_loop(st, labels(), [] (const std::string &s) { return std::hash<std::string_view>()(s); });
+});
+OMTL_BENCHMARK("hash/omtl/log_4k",            [] (bench::state &st) { hash_loop(st, log_chunks(), omtl::str::hash()); });
+OMTL_BENCHMARK("hash/std_string_view/log_4k", [] (bench::state &st) {
+  hash_loop(st, log_chunks(), [] (const std::string &s) { return std::hash<std::string_view>()(s); });
+});
+
+// The same keys probed over and over, as a view and as a hashed view.
+OMTL_BENCHMARK("hash_lookup/omtl_view/labels", [] (bench::state &st) {
+  std::unordered_set<view> set;
+  for (const std::string &id : few_labels()) { set.insert(as_view(id)); }
+  std::vector<view> keys;
+  for (const std::string &id : labels()) { keys.push_back(as_view(id)); }
+  st.items = keys.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t hits = 0;
+    for (view k : keys) { hits += set.count(k); }
+    bench::do_not_optimize(hits);
+  }
+});
+OMTL_BENCHMARK("hash_lookup/omtl_hashed_view/labels", [] (bench::state &st) {
+  std::unordered_set<omtl::str::hashed_view> set;
+  for (const std::string &id : few_labels()) { set.insert(omtl::str::hashed_view(as_view(id))); }
+  std::vector<omtl::str::hashed_view> keys;
+  for (const std::string &id : labels()) { keys.emplace_back(as_view(id)); }
+  st.items = keys.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t hits = 0;
+    for (const auto &k : keys) { hits += set.count(k); }
+    bench::do_not_optimize(hits);
+  }
+});
+
+
+// Header-name recognition: a compile-time perfect hash against a hash map
+// and a comparison chain, probed with a mix of known and unknown names.
+using namespace omtl::str::literals;
+
+constexpr auto header_ids = omtl::str::make_static_map<int>({
+  { "host"sv, 1 }, { "user-agent"sv, 2 }, { "accept"sv, 3 }, { "accept-encoding"sv, 4 },
+  { "accept-language"sv, 5 }, { "content-type"sv, 6 }, { "content-length"sv, 7 }, { "connection"sv, 8 },
+  { "cookie"sv, 9 }, { "authorization"sv, 10 }, { "cache-control"sv, 11 }, { "referer"sv, 12 },
+  { "origin"sv, 13 }, { "if-none-match"sv, 14 }, { "if-modified-since"sv, 15 }, { "x-request-id"sv, 16 },
+});
+
+const std::vector<view> &header_probes (void) {
+  static const std::vector<view> probes = [] {
+    static const view extra[] = { "x-forwarded-for"sv, "dnt"sv, "te"sv, "x-custom-trace"sv };
+    std::vector<view> out;
+    bench::rng r(5);
+    for (size_t i = 0; i < 4096; ++i) {
+      out.push_back(r.below(4) ? header_ids.keys()[r.below(header_ids.size())] : extra[r.below(4)]);
+    }
+    return out;
+  }();
+  return probes;
+}
+
+template <class Lookup>
+void header_loop (bench::state &st, Lookup lookup) {
+  st.items = header_probes().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    int sum = 0;
+    for (view name : header_probes()) { sum += lookup(name); }
+    bench::do_not_optimize(sum);
+  }
+}
+
+OMTL_BENCHMARK("keyword/omtl_static_map/headers", [] (bench::state &st) {
+  header_loop(st, [] (view name) { return header_ids.value_or(name, 0); });
+});
+OMTL_BENCHMARK("keyword/std_unordered_map/headers", [] (bench::state &st) {
+  std::unordered_map<std::string_view, int> ids;
+  for (size_t i = 0; i < header_ids.size(); ++i) {
+    ids.emplace(std::string_view(header_ids.keys()[i].data(), header_ids.keys()[i].size()), int(i + 1));
+  }
+  header_loop(st, [&ids] (view name) {
+    auto found = ids.find(std::string_view(name.data(), name.size()));
+    return found == ids.end() ? 0 : found->second;
+  });
+});
+OMTL_BENCHMARK("keyword/compare_chain/headers", [] (bench::state &st) {
+  header_loop(st, [] (view name) {
+    for (size_t i = 0; i < header_ids.size(); ++i) {
+      if (header_ids.keys()[i] == name) { return int(i + 1); }
+    }
+    return 0;
+  });
+});
+
+
+// Case-insensitive matching: the same probes as they arrive on the wire,
+// in mixed case, against one header name; and a scan of the log for an
+// upper-case needle. The baselines lower a copy first.
+const std::vector<std::string> &wire_headers (void) {
+  static const std::vector<std::string> names = [] {
+    std::vector<std::string> out;
+    bench::rng r(6);
+    for (view name : header_probes()) {
+      std::string s(name.data(), name.size());
+      for (char &c : s) { if (c >= 'a' && c <= 'z' && r.below(2)) { c = char(c - 32); } }
+      out.push_back(std::move(s));
+    }
+    return out;
+  }();
+  return names;
+}
+
+std::string ascii_lowered (std::string s) {
+  for (char &c : s) { if (c >= 'A' && c <= 'Z') { c = char(c + 32); } }
+  return s;
+}
+
+template <class Match>
+void icase_loop (bench::state &st, Match match) {
+  st.items = wire_headers().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    size_t hits = 0;
+    for (const std::string &name : wire_headers()) { hits += match(as_view(name)); }
+    bench::do_not_optimize(hits);
+  }
+}
+
+const char icase_header[] = "if-modified-since";
+const char icase_needle[] = "STATUS=404 ";
+
+OMTL_BENCHMARK("icase/omtl_equals_icase/headers", [] (bench::state &st) {
+  icase_loop(st, [] (view name) { return omtl::str::equals_icase(name, view(icase_header)); });
+});
+OMTL_BENCHMARK("icase/omtl_icase_view/headers", [] (bench::state &st) {
+  icase_loop(st, [] (view name) { return omtl::str::as_icase(name) == omtl::str::icase_view(icase_header); });
+});
+OMTL_BENCHMARK("icase/std_lowered_copy/headers", [] (bench::state &st) {
+  icase_loop(st, [] (view name) { return ascii_lowered(std::string(name.data(), name.size())) == icase_header; });
+});
+
+OMTL_BENCHMARK("icase/omtl_find_icase/log", [] (bench::state &st) {
+  st.bytes = events().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(omtl::str::find_icase(as_view(events()), view(icase_needle)));
+  }
+});
+OMTL_BENCHMARK("icase/omtl_icase_view/log", [] (bench::state &st) {
+  st.bytes = events().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(omtl::str::as_icase(as_view(events())).find(omtl::str::icase_view(icase_needle)));
+  }
+});
+OMTL_BENCHMARK("icase/std_lowered_copy/log", [] (bench::state &st) {
+  st.bytes = events().size();
+  const std::string needle = ascii_lowered(icase_needle);
+  for (size_t i = 0; i < st.iterations; ++i) {
+    bench::do_not_optimize(ascii_lowered(events()).find(needle));
+  }
+});
+
+
+// UTF-8 text that is mostly ASCII, as user input usually is, and text with
+// a multi-byte sequence in most words. The baselines decode one code point
+// at a time, as a byte-oriented library does.
+const std::string &mostly_ascii (void) {
+  static const std::string text = bench::utf8_text(32 * 1024, 90);
+  return text;
+}
+
+const std::string &multilingual (void) {
+  static const std::string text = bench::utf8_text(32 * 1024, 20);
+  return text;
+}
+
+bool decode_valid (const std::string &text) {
+  for (size_t i = 0; i < text.size();) {
+    const omtl::str::utf8::decoded d = omtl::str::utf8::decode(text.data() + i, text.size() - i);
+    if (!d.valid) { return false; }
+    i += d.length;
+  }
+  return true;
+}
+
+size_t decode_to_utf16 (const std::string &text, char16_t *out) {
+  char16_t *start = out;
+  for (size_t i = 0; i < text.size();) {
+    const omtl::str::utf8::decoded d = omtl::str::utf8::decode(text.data() + i, text.size() - i);
+    i += d.length;
+    if (d.code_point >= 0x10000) {
+      *out++ = char16_t(0xD800 + ((d.code_point - 0x10000) >> 10));
+      *out++ = char16_t(0xDC00 + ((d.code_point - 0x10000) & 0x3FF));
+    } else {
+      *out++ = char16_t(d.code_point);
+    }
+  }
+  return size_t(out - start);
+}
+
+template <class Op>
+void utf8_loop (bench::state &st, const std::string &text, Op op) {
+  st.bytes = text.size();
+  for (size_t i = 0; i < st.iterations; ++i) { bench::do_not_optimize(op(text)); }
+}
+
+OMTL_BENCHMARK("utf8_validate/omtl/mostly_ascii", [] (bench::state &st) {
+  utf8_loop(st, mostly_ascii(), [] (const std::string &t) { return omtl::str::utf8::valid(as_view(t)); });
+});
+OMTL_BENCHMARK("utf8_validate/decode_loop/mostly_ascii", [] (bench::state &st) { utf8_loop(st, mostly_ascii(), decode_valid); });
+OMTL_BENCHMARK("utf8_validate/omtl/multilingual", [] (bench::state &st) {
+  utf8_loop(st, multilingual(), [] (const std::string &t) { return omtl::str::utf8::valid(as_view(t)); });
+});
+OMTL_BENCHMARK("utf8_validate/decode_loop/multilingual", [] (bench::state &st) { utf8_loop(st, multilingual(), decode_valid); });
+
+OMTL_BENCHMARK("utf8_length/omtl/multilingual", [] (bench::state &st) {
+  utf8_loop(st, multilingual(), [] (const std::string &t) { return omtl::str::utf8::length(as_view(t)); });
+});
+OMTL_BENCHMARK("utf8_length/code_points/multilingual", [] (bench::state &st) {
+  utf8_loop(st, multilingual(), [] (const std::string &t) {
+    size_t n = 0;
+    for (char32_t cp : omtl::str::utf8::code_points(as_view(t))) { n += cp != 0; }
+    return n;
+  });
+});
+
+OMTL_BENCHMARK("utf8_to_utf16/omtl/mostly_ascii", [] (bench::state &st) {
+  std::u16string out(mostly_ascii().size(), u'\0');
+  utf8_loop(st, mostly_ascii(), [&out] (const std::string &t) { return omtl::str::utf8::to_utf16(as_view(t), &out[0]); });
+});
+OMTL_BENCHMARK("utf8_to_utf16/decode_loop/mostly_ascii", [] (bench::state &st) {
+  std::u16string out(mostly_ascii().size(), u'\0');
+  utf8_loop(st, mostly_ascii(), [&out] (const std::string &t) { return decode_to_utf16(t, &out[0]); });
+});
+OMTL_BENCHMARK("utf8_to_utf16/omtl/multilingual", [] (bench::state &st) {
+  std::u16string out(multilingual().size(), u'\0');
+  utf8_loop(st, multilingual(), [&out] (const std::string &t) { return omtl::str::utf8::to_utf16(as_view(t), &out[0]); });
+});
+OMTL_BENCHMARK("utf8_to_utf16/decode_loop/multilingual", [] (bench::state &st) {
+  std::u16string out(multilingual().size(), u'\0');
+  utf8_loop(st, multilingual(), [&out] (const std::string &t) { return decode_to_utf16(t, &out[0]); });
+});
+
+
+// Numbers as they arrive in fields: short counts, 15- to 19-digit ids and
+// timestamps, and decimals. strtol and strtod get the terminated strings
+// for free here; on split fields they would need a copy first, as the
+// csv_fields cases show.
+const std::vector<std::string> &short_ints (void) {
+  static const std::vector<std::string> n = bench::integers(10000, 1, 6);
+  return n;
+}
+
+const std::vector<std::string> &long_ints (void) {
+  static const std::vector<std::string> n = bench::integers(10000, 15, 18);
+  return n;
+}
+
+const std::vector<std::string> &decimal_numbers (void) {
+  static const std::vector<std::string> n = bench::decimals(10000);
+  return n;
+}
+
+template <class Op>
+void parse_loop (bench::state &st, const std::vector<std::string> &numbers, Op op) {
+  st.items = numbers.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &n : numbers) { bench::do_not_optimize(op(n)); }
+  }
+}
+
+int64_t parse_int (const std::string &n)  { return omtl::str::parse<int64_t>(as_view(n)).value; }
+int64_t strtol_int (const std::string &n) { return std::strtoll(n.c_str(), nullptr, 10); }
+int64_t from_chars_int (const std::string &n) {
+  int64_t v = 0;
+  std::from_chars(n.data(), n.data() + n.size(), v);
+  return v;
+}
+
+OMTL_BENCHMARK("parse/omtl/short_ints",       [] (bench::state &st) { parse_loop(st, short_ints(), parse_int); });
+OMTL_BENCHMARK("parse/strtol/short_ints",     [] (bench::state &st) { parse_loop(st, short_ints(), strtol_int); });
+OMTL_BENCHMARK("parse/from_chars/short_ints", [] (bench::state &st) { parse_loop(st, short_ints(), from_chars_int); });
+OMTL_BENCHMARK("parse/omtl/long_ints",        [] (bench::state &st) { parse_loop(st, long_ints(), parse_int); });
+OMTL_BENCHMARK("parse/strtol/long_ints",      [] (bench::state &st) { parse_loop(st, long_ints(), strtol_int); });
+OMTL_BENCHMARK("parse/from_chars/long_ints",  [] (bench::state &st) { parse_loop(st, long_ints(), from_chars_int); });
+
+// Ids behind 20 to 27 zeros, and runs of nothing but zeros, as views that
+// stop before more zeros: digits past a view must not be read. The
+// corpus is checked against std::from_chars once, before any timing.
+struct padded_number {
+  std::string text;
+  size_t      length;
+};
+
+const std::vector<padded_number> &zero_padded (void) {
+  static const std::vector<padded_number> n = [] {
+    std::vector<padded_number> out;
+    size_t i = 0;
+    for (const std::string &id : long_ints()) {
+      if (id[0] == '-') { continue; }
+      std::string text = std::string(20 + i % 8, '0') + id;
+      const size_t length = text.size();
+      out.push_back({ text + "0000", length });
+      out.push_back({ std::string(48, '0'), 20 + i++ % 24 });
+    }
+    for (const padded_number &p : out) {
+      uint64_t expected = 0;
+      std::from_chars(p.text.data(), p.text.data() + p.length, expected);
+      const omtl::str::parse_result<uint64_t> r = omtl::str::parse<uint64_t>(view(p.text.data(), p.length));
+      if (!r || r.value != expected) {
+        std::fprintf(stderr, "parse mismatch on %.*s\n", static_cast<int>(p.length), p.text.c_str());
+        std::abort();
+      }
+    }
+    return out;
+  }();
+  return n;
+}
+
+OMTL_BENCHMARK("parse/omtl/zero_padded", [] (bench::state &st) {
+  st.items = zero_padded().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const padded_number &p : zero_padded()) {
+      bench::do_not_optimize(omtl::str::parse<uint64_t>(view(p.text.data(), p.length)).value);
+    }
+  }
+});
+OMTL_BENCHMARK("parse/from_chars/zero_padded", [] (bench::state &st) {
+  st.items = zero_padded().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const padded_number &p : zero_padded()) {
+      uint64_t v = 0;
+      std::from_chars(p.text.data(), p.text.data() + p.length, v);
+      bench::do_not_optimize(v);
+    }
+  }
+});
+
+OMTL_BENCHMARK("parse/omtl/decimals", [] (bench::state &st) {
+  parse_loop(st, decimal_numbers(), [] (const std::string &n) { return omtl::str::parse<double>(as_view(n)).value; });
+});
+OMTL_BENCHMARK("parse/strtod/decimals", [] (bench::state &st) {
+  parse_loop(st, decimal_numbers(), [] (const std::string &n) { return std::strtod(n.c_str(), nullptr); });
+});
+OMTL_BENCHMARK("parse/from_chars/decimals", [] (bench::state &st) {
+  parse_loop(st, decimal_numbers(), [] (const std::string &n) {
+    double v = 0;
+    std::from_chars(n.data(), n.data() + n.size(), v);
+    return v;
+  });
+});
+
+// Price, quantity and timestamp of each row, straight from the split
+// fields, or through the string copies strtod and strtoll need.
+OMTL_BENCHMARK("parse/omtl/csv_fields", [] (bench::state &st) {
+  st.items = csv().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      double  price = 0;
+      int64_t total = 0;
+      size_t  column = 0;
+      for (view field : omtl::str::lazy_split(as_view(row), ',')) {
+        if (column == 2)                     { price = omtl::str::parse<double>(field).value; }
+        else if (column == 3 || column == 6) { total += omtl::str::parse<int64_t>(field).value; }
+        ++column;
+      }
+      bench::do_not_optimize(price);
+      bench::do_not_optimize(total);
+    }
+  }
+});
+OMTL_BENCHMARK("parse/copy_strtod/csv_fields", [] (bench::state &st) {
+  st.items = csv().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &row : csv()) {
+      double  price = 0;
+      int64_t total = 0;
+      size_t  column = 0;
+      for (view field : omtl::str::lazy_split(as_view(row), ',')) {
+        const std::string copy(field.data(), field.size());
+        if (column == 2)                     { price = std::strtod(copy.c_str(), nullptr); }
+        else if (column == 3 || column == 6) { total += std::strtoll(copy.c_str(), nullptr, 10); }
+        ++column;
+      }
+      bench::do_not_optimize(price);
+      bench::do_not_optimize(total);
+    }
+  }
+});
+
+const std::vector<int64_t> &int_values (void) {
+  static const std::vector<int64_t> v = [] {
+    std::vector<int64_t> out;
+    for (const std::string &n : short_ints()) { out.push_back(parse_int(n)); }
+    for (const std::string &n : long_ints())  { out.push_back(parse_int(n)); }
+    return out;
+  }();
+  return v;
+}
+
+const std::vector<double> &double_values (void) {
+  static const std::vector<double> v = [] {
+    std::vector<double> out;
+    for (const std::string &n : decimal_numbers()) { out.push_back(omtl::str::parse<double>(as_view(n)).value); }
+    return out;
+  }();
+  return v;
+}
+
+template <class T, class Op>
+void format_loop (bench::state &st, const std::vector<T> &values, Op op) {
+  char out[64];
+  st.items = values.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (T v : values) {
+      bench::do_not_optimize(op(v, out));
+      bench::do_not_optimize(out[0]);
+    }
+  }
+}
+
+OMTL_BENCHMARK("format/omtl/ints", [] (bench::state &st) {
+  format_loop(st, int_values(), [] (int64_t v, char *out) { return omtl::str::format(v, out); });
+});
+OMTL_BENCHMARK("format/to_chars/ints", [] (bench::state &st) {
+  format_loop(st, int_values(), [] (int64_t v, char *out) { return std::to_chars(out, out + 64, v).ptr - out; });
+});
+OMTL_BENCHMARK("format/snprintf/ints", [] (bench::state &st) {
+  format_loop(st, int_values(), [] (int64_t v, char *out) { return std::snprintf(out, 64, "%lld", static_cast<long long>(v)); });
+});
+OMTL_BENCHMARK("format/omtl/doubles", [] (bench::state &st) {
+  format_loop(st, double_values(), [] (double v, char *out) { return omtl::str::format(v, out); });
+});
+OMTL_BENCHMARK("format/snprintf/doubles", [] (bench::state &st) {
+  format_loop(st, double_values(), [] (double v, char *out) { return std::snprintf(out, 64, "%.17g", v); });
+});
+
+
+// Identifiers are mostly 8 to 30 characters: past libstdc++'s 15-character
+// inline buffer, largely within basic_string's 23.
+using pooled_string = omtl::str::basic_string<char, std::char_traits<char>, omtl::str::storage_allocator<char>>;
+
+template <class String, class Make>
+void construct_all (bench::state &st, const std::vector<std::string> &ids, Make make) {
+  st.items = ids.size();
+  std::vector<String> out;
+  out.reserve(ids.size());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    out.clear();
+    for (const std::string &id : ids) { out.push_back(make(id)); }
+    bench::do_not_optimize(out.back());
+  }
+}
+
+template <class String>
+void copy_all (bench::state &st, const std::vector<String> &ids) {
+  st.items = ids.size();
+  std::vector<String> out;
+  out.reserve(ids.size());
+  for (size_t i = 0; i < st.iterations; ++i) {
+    out.assign(ids.begin(), ids.end());
+    bench::do_not_optimize(out.back());
+  }
+}
+
+template <class String, class View>
+void concat_all (bench::state &st, const std::vector<std::string> &ids, View suffix) {
+  st.items = ids.size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    for (const std::string &id : ids) {
+      String s(id.data(), id.size());
+      s += suffix;
+      bench::do_not_optimize(s.data());
+    }
+  }
+}
+
+OMTL_BENCHMARK("string_construct/omtl/labels", [] (bench::state &st) {
+  construct_all<omtl::str::string>(st, labels(), [] (const std::string &id) { return omtl::str::string(as_view(id)); });
+});
+OMTL_BENCHMARK("string_construct/omtl_storage/labels", [] (bench::state &st) {
+  st.items = labels().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    pool p(4096, growing);
+    std::vector<pooled_string> out;
+    out.reserve(labels().size());
+    for (const std::string &id : labels()) { out.emplace_back(id.data(), id.size(), omtl::str::storage_allocator<char>(p)); }
+    bench::do_not_optimize(out.back());
+  }
+});
+OMTL_BENCHMARK("string_construct/std_string/labels", [] (bench::state &st) {
+  construct_all<std::string>(st, labels(), [] (const std::string &id) { return std::string(id.data(), id.size()); });
+});
+
+OMTL_BENCHMARK("string_copy/omtl/labels", [] (bench::state &st) {
+  std::vector<omtl::str::string> ids;
+  for (const std::string &id : labels()) { ids.emplace_back(as_view(id)); }
+  copy_all(st, ids);
+});
+OMTL_BENCHMARK("string_copy/std_string/labels", [] (bench::state &st) { copy_all(st, labels()); });
+
+OMTL_BENCHMARK("string_concat/omtl/labels", [] (bench::state &st) { concat_all<omtl::str::string>(st, labels(), view("_sum")); });
+OMTL_BENCHMARK("string_concat/std_string/labels", [] (bench::state &st) { concat_all<std::string>(st, labels(), std::string_view("_sum")); });
+
+
+
+// One output record per CSV row, the row framed by a header and a
+// trailer: a response assembled from parsed input and fixed text.
+template <class Emit>
+void records (Emit emit) {
+  for (const std::string &row : csv()) {
+    emit(view("record: "));
+    emit(as_view(row));
+    emit(view(" [source=catalog.csv; schema=v8; checked]\n"));
+  }
+}
+
+OMTL_BENCHMARK("build/std_string_append/csv_records", [] (bench::state &st) {
+  st.items = csv().size();
+  for (size_t i = 0; i < st.iterations; ++i) {
+    std::string out;
+    records([&out] (view piece) { out.append(piece.data(), piece.size()); });
+    bench::do_not_optimize(out.data());
+  }
+});
+// A builder kept across responses, as a connection would.
+OMTL_BENCHMARK("build/omtl_builder_str/csv_records", [] (bench::state &st) {
+  st.items = csv().size();
+  omtl::str::string_builder out;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    out.clear();
+    records([&out] (view piece) { out.append(piece); });
+    bench::do_not_optimize(out.str().data());
+  }
+});
+#ifdef OMTL_HAVE_WRITEV
+OMTL_BENCHMARK("build/omtl_builder_iovec/csv_records", [] (bench::state &st) {
+  st.items = csv().size();
+  omtl::str::string_builder out;
+  std::vector<iovec> iov;
+  for (size_t i = 0; i < st.iterations; ++i) {
+    out.clear();
+    records([&out] (view piece) { out.append(piece); });
+    iov.resize(out.pieces());
+    bench::do_not_optimize(out.to_iovec(iov.data(), iov.size()));
+  }
+});
+#endif
+
+}  // namespace
+
+
+int main (int argc, char **argv) {
+  return bench::run(argc, argv, "str");
+}
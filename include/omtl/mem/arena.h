@@ -0,0 +1,145 @@
+#pragma once
+
+#ifndef OMTL_MEMORY_ARENA_H
+#define OMTL_MEMORY_ARENA_H
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <omtl/mem/owner.h>
+
+
+namespace omtl {
+inline namespace mem {
+
+
+/// @struct Deleter for objects living in an arena: runs the destructor and
+///         leaves the memory to the arena. Stateless, so an arena owner is
+///         as small as a raw pointer.
+template <typename T>
+struct arena_deleter {
+  arena_deleter(void) noexcept = default;
+
+  template <typename U, typename = std::enable_if_t<std::is_convertible<ptr<U>, ptr<T>>::value>>
+  arena_deleter(const arena_deleter<U> &) noexcept { }
+
+  void operator()(ptr<T> p) const noexcept { p->~T(); }
+};
+
+
+/// @class Monotonic allocator: bumps a pointer through blocks growing
+///        geometrically from @p block_size up to @p max_block bytes, and
+///        gives memory back only all at once with clear() or reset().
+///        Requests bigger than a quarter of the next block get a dedicated
+///        block, so they do not waste the tail of the current one.
+///        Objects made here must be destroyed before the arena is cleared.
+///        Not thread-safe.
+class arena {
+public:
+  template <typename T>
+  using owner_type = owner<T, arena_deleter<T>>;
+
+  static constexpr size_t default_max_block = size_t(1) << 20;
+
+  explicit arena(size_t block_size = 4096, size_t max_block = default_max_block)
+    : _next_block(std::max<size_t>(block_size, 64)), _max_block(std::max(max_block, _next_block)) { }
+
+  arena(const arena &) = delete;
+  arena &operator= (const arena &) = delete;
+
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    assert(align != 0 && (align & (align - 1)) == 0);
+    if (_current < _blocks.size()) {
+      if (void *p = _blocks[_current].take(bytes, align)) { return p; }
+    }
+    return _blocks[next_block(bytes + align - 1)].take(bytes, align);
+  }
+
+  template <typename T, typename ...Args>
+  ptr<T> construct(Args &&...args) {
+    return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T, typename ...Args>
+  owner_type<T> make(Args &&...args) {
+    return owner_type<T>(construct<T>(std::forward<Args>(args)...));
+  }
+
+  /// @brief Rewinds every block; dedicated blocks are freed.
+  void clear(void) {
+    _blocks.erase(std::remove_if(_blocks.begin(), _blocks.end(), [] (const block_t &b) { return b.dedicated; }),
+                  _blocks.end());
+    for (block_t &b : _blocks) { b.used = 0; }
+    _current = 0;
+  }
+
+  /// @brief Rewinds and frees all blocks except the first one.
+  void reset(void) {
+    if (_blocks.size() > 1) { _blocks.erase(_blocks.begin() + 1, _blocks.end()); }
+    clear();
+  }
+
+  size_t capacity(void) const noexcept {
+    size_t total = 0;
+    for (const block_t &b : _blocks) { total += b.size; }
+    return total;
+  }
+
+private:
+  struct block_t {
+    block_t(size_t sz, bool single) : data(new unsigned char[sz]), size(sz), dedicated(single) { }
+
+    void *take(size_t bytes, size_t align) noexcept {
+      const uintptr_t base  = reinterpret_cast<uintptr_t>(data.get());
+      const uintptr_t start = (base + used + align - 1) & ~uintptr_t(align - 1);
+      if (start - base > size || bytes > size - (start - base)) { return nullptr; }
+      used = start - base + bytes;
+      return reinterpret_cast<void *>(start);
+    }
+
+    bool capable(size_t bytes) const noexcept { return bytes <= size - used; }
+
+    std::unique_ptr<unsigned char[]> data;
+    size_t size;
+    size_t used = 0;
+    bool   dedicated;
+  };
+
+  /// @brief Index of a block with @p bytes free, reusing blocks kept by
+  ///        clear() before allocating. Kept blocks too small for the
+  ///        request are passed over until the next clear().
+  size_t next_block(size_t bytes) {
+    if (bytes > _next_block / 4) {
+      // Dedicated blocks go before the current one so it keeps filling.
+      const size_t at = std::min(_current, _blocks.size());
+      _blocks.emplace(_blocks.begin() + at, bytes, true);
+      if (_current < _blocks.size() - 1) { ++_current; }
+      return at;
+    }
+    for (size_t i = _current + 1; i < _blocks.size(); ++i) {
+      if (!_blocks[i].dedicated && _blocks[i].capable(bytes)) { return _current = i; }
+    }
+    _blocks.emplace_back(_next_block, false);
+    _next_block = std::min(_next_block * 2, _max_block);
+    return _current = _blocks.size() - 1;
+  }
+
+  std::vector<block_t> _blocks;
+  size_t _current    = 0;
+  size_t _next_block;
+  size_t _max_block;
+};
+
+
+}  // inline namespace mem
+}  // namespace omtl
+
+#endif  // OMTL_MEMORY_ARENA_H
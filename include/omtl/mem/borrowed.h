@@ -0,0 +1,215 @@
+#pragma once
+
+#ifndef OMTL_MEMORY_BORROWED_H
+#define OMTL_MEMORY_BORROWED_H
+
+
+#include <cstddef>
+#include <type_traits>
+
+#include <omtl/mem/ptr.h>
+
+// DEBUG_BORROWED_PTR is the historical spelling of the switch.
+#if defined(DEBUG_BORROWED_PTR) && !defined(OMTL_DEBUG_BORROWED_PTR)
+#  define OMTL_DEBUG_BORROWED_PTR
+#endif
+
+#ifdef OMTL_DEBUG_BORROWED_PTR
+#  include <atomic>
+#  include <cstdint>
+#  include <cstdio>
+#  include <cstdlib>
+#endif
+
+// Taking a borrow allocates its slot when checks are on.
+#ifdef OMTL_DEBUG_BORROWED_PTR
+#  define OMTL_BORROW_NOEXCEPT
+#else
+#  define OMTL_BORROW_NOEXCEPT noexcept
+#endif
+
+
+namespace omtl {
+inline namespace mem {
+
+
+#ifndef OMTL_DEBUG_BORROWED_PTR
+
+/// @typedef template pointer type
+///          Used for borrowing from @ref{owned} pointer type.
+template <typename T>
+using borrowed = ptr<T>;
+
+
+namespace detail {
+
+/// @struct Borrow bookkeeping of an owner; nothing without
+///         OMTL_DEBUG_BORROWED_PTR, and an empty base of owner.
+struct borrow_tracker {
+  void adopt (borrow_tracker &) noexcept { }
+  void retire (void) noexcept { }
+
+  template <typename T>
+  borrowed<T> lend (ptr<T> p) const noexcept { return p; }
+};
+
+}  // namespace detail
+
+#else // OMTL_DEBUG_BORROWED_PTR
+
+namespace detail {
+
+inline void report_dangling_borrow (const void *object) {
+  std::fprintf(stderr, "omtl: borrowed pointer %p used after its owner let go of it\n", object);
+  std::abort();
+}
+
+}  // namespace detail
+
+/// @brief Called when a borrowed pointer is used after its owner destroyed,
+///        reset or released the object. Defaults to a message and abort().
+///        Set it before any thread can hit a violation.
+inline void (*on_dangling_borrow)(const void *object) = &detail::report_dangling_borrow;
+
+
+namespace detail {
+
+/// @struct Generation counter shared by an owner and its borrows. Slots are
+///         recycled but never freed, so a stale borrow can always read its
+///         slot and see that the generation moved on.
+struct borrow_slot {
+  std::atomic<uint32_t> generation{ 1 };
+  borrow_slot          *next = nullptr;
+};
+
+/// @brief Per-thread free list; a slot retired on another thread simply
+///        joins that thread's list. Slots left when a thread exits stay
+///        allocated, which keeps stale borrows from other threads readable.
+inline borrow_slot *&borrow_free_list (void) noexcept {
+  thread_local borrow_slot *head = nullptr;
+  return head;
+}
+
+inline borrow_slot *acquire_borrow_slot (void) {
+  borrow_slot *&head = borrow_free_list();
+  if (!head) {
+    constexpr size_t batch = 256;
+    borrow_slot *chunk = new borrow_slot[batch];  // Never freed, see borrow_slot.
+    for (size_t i = 0; i < batch - 1; ++i) { chunk[i].next = &chunk[i + 1]; }
+    head = chunk;
+  }
+  borrow_slot *slot = head;
+  head = slot->next;
+  return slot;
+}
+
+inline void retire_borrow_slot (borrow_slot *slot) noexcept {
+  slot->generation.fetch_add(1, std::memory_order_release);
+  borrow_slot *&head = borrow_free_list();
+  slot->next = head;
+  head = slot;
+}
+
+struct borrow_tracker;
+
+}  // namespace detail
+
+
+/// @struct Checked borrowed pointer: the pointer plus the generation of its
+///         owner's slot at borrow time. Every access compares the two, one
+///         load and a predictable branch, and calls on_dangling_borrow once
+///         the owner destroyed, reset or released the object. Borrows made
+///         from raw pointers are not tracked.
+template <typename T>
+struct borrowed {
+public:
+  using element_type = T;
+  using pointer      = ptr<T>;
+  using lvalue_type  = typename std::add_lvalue_reference<element_type>::type;
+
+  borrowed (void) noexcept = default;
+  borrowed (std::nullptr_t) noexcept { }
+  borrowed (pointer p) noexcept : _ptr(p) { }
+
+  template <typename U, typename = std::enable_if_t<std::is_convertible<ptr<U>, pointer>::value>>
+  borrowed (const borrowed<U> &o) noexcept : _ptr(o._ptr), _slot(o._slot), _generation(o._generation) { }
+
+  pointer get (void) const noexcept { check(); return _ptr; }
+
+  lvalue_type operator*  (void) const noexcept { return *get(); }
+  pointer     operator-> (void) const noexcept { return  get(); }
+  operator pointer (void) const noexcept { return get(); }
+
+  /// @brief Whether the owner still holds the object; never reports.
+  bool valid (void) const noexcept {
+    return !_slot || _slot->generation.load(std::memory_order_acquire) == _generation;
+  }
+
+private:
+  template <typename U> friend struct borrowed;
+  friend struct detail::borrow_tracker;
+
+  borrowed (pointer p, detail::borrow_slot *slot, uint32_t generation) noexcept
+    : _ptr(p), _slot(slot), _generation(generation) { }
+
+  void check (void) const noexcept {
+    if (!valid()) { on_dangling_borrow(_ptr); }
+  }
+
+  pointer              _ptr        = nullptr;
+  detail::borrow_slot *_slot       = nullptr;
+  uint32_t             _generation = 0;
+};
+
+
+namespace detail {
+
+/// @struct Borrow bookkeeping of an owner: the slot its borrows check,
+///         taken on the first borrow() and retired with the object. Any
+///         number of threads may borrow from a const owner at once: the
+///         first slot installed wins, and the others go back unused.
+struct borrow_tracker {
+  borrow_tracker (void) noexcept = default;
+  borrow_tracker (const borrow_tracker &) = delete;
+  borrow_tracker &operator= (const borrow_tracker &) = delete;
+
+  ~borrow_tracker (void) { retire(); }
+
+  /// @brief Takes over the borrows of @p o, whose object now lives here.
+  void adopt (borrow_tracker &o) noexcept {
+    retire();
+    _slot.store(o._slot.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_release);
+  }
+
+  void retire (void) noexcept {
+    if (borrow_slot *slot = _slot.exchange(nullptr, std::memory_order_acq_rel)) { retire_borrow_slot(slot); }
+  }
+
+  template <typename T>
+  borrowed<T> lend (ptr<T> p) const {
+    if (!p) { return borrowed<T>(); }
+    borrow_slot *slot = _slot.load(std::memory_order_acquire);
+    if (!slot) {
+      borrow_slot *mine = acquire_borrow_slot();
+      if (_slot.compare_exchange_strong(slot, mine, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        slot = mine;
+      } else {
+        retire_borrow_slot(mine);
+      }
+    }
+    return borrowed<T>(p, slot, slot->generation.load(std::memory_order_relaxed));
+  }
+
+private:
+  mutable std::atomic<borrow_slot *> _slot{ nullptr };
+};
+
+}  // namespace detail
+
+#endif // OMTL_DEBUG_BORROWED_PTR
+
+
+}  // inline namespace mem
+}  // namespace omtl
+
+#endif  // OMTL_MEMORY_BORROWED_H
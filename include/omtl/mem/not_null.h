@@ -3,9 +3,14 @@
 #ifndef OMTL_MEMORY_NOT_NULL_H
 #define OMTL_MEMORY_NOT_NULL_H
 
+#include <cassert>
+#include <cstddef>
+#include <exception>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
-#include <omtl/utils/traits.h>
 #include <omtl/mem/ptr.h>
 
 
@@ -13,59 +18,146 @@ namespace omtl {
 inline namespace mem {
 
 
+/// @struct Null policies of not_null: what a null argument does.
+///         Checks only happen where a possibly null value enters a
+///         not_null, never between not_nulls or on access.
+struct null_assert {
+  static void violation (void) noexcept { assert(!"not_null constructed from null"); }
+};
+
+struct null_throw {
+  [[noreturn]] static void violation (void) { throw std::invalid_argument("not_null constructed from null"); }
+};
+
+struct null_terminate {
+  [[noreturn]] static void violation (void) noexcept { std::terminate(); }
+};
+
+/// @struct Trusts the caller; not even debug builds check.
+struct null_unchecked {
+  static constexpr bool unchecked = true;
+};
+
+
+#ifndef OMTL_NOT_NULL_POLICY
+/// @def OMTL_NOT_NULL_POLICY
+///      Policy of not_null when none is given, null_assert by default.
+#  define OMTL_NOT_NULL_POLICY ::omtl::mem::null_assert
+#endif
+
+
+namespace detail {
+
+template <class Policy, class = void>
+struct is_unchecked : std::false_type { };
+
+template <class Policy>
+struct is_unchecked<Policy, std::void_t<decltype(Policy::unchecked)>> : std::bool_constant<Policy::unchecked> { };
+
+template <class Policy, bool = is_unchecked<Policy>::value>
+struct is_nothrow_policy : std::true_type { };
+
+template <class Policy>
+struct is_nothrow_policy<Policy, false> : std::bool_constant<noexcept(Policy::violation())> { };
+
+/// Views and spans are null when their data() is; pointers and smart
+/// pointers compare to nullptr.
+template <class T>
+constexpr auto is_null (const T &p, int) noexcept -> decltype(p.data() == nullptr) { return p.data() == nullptr; }
+
 template <class T>
+constexpr bool is_null (const T &p, long) noexcept { return p == nullptr; }
+
+}  // namespace detail
+
+
+/// @class Value that is never null: a pointer, smart pointer or view.
+///        Null is rejected when a value enters, per @p Policy; copies and
+///        conversions between not_nulls are not checked again, access is
+///        never checked, and the wrapper has the size and triviality of T.
+///        A not_null of a move-only type is empty once moved from and may
+///        then only be assigned to or destroyed.
+template <class T, class Policy = OMTL_NOT_NULL_POLICY>
 class not_null {
-  using pointer = T;
+public:
+  using pointer     = T;
+  using policy_type = Policy;
+  using get_type    = std::conditional_t<std::is_trivially_copyable<T>::value, T, const T &>;
+
+  static constexpr bool checked_nothrow = detail::is_nothrow_policy<Policy>::value;
 
   not_null (void) = delete;
+  not_null (std::nullptr_t) = delete;
+  not_null &operator= (std::nullptr_t) = delete;
 
-  template <typename U = T, IF_COPY_CONSTRUCTABLE(U)>
-  not_null (const U &p) NOEXCEPT_COPY(U)
+  template <typename U = T, typename = std::enable_if_t<std::is_convertible<const U &, T>::value>>
+  constexpr not_null (const U &p) noexcept(std::is_nothrow_constructible<T, const U &>::value && checked_nothrow)
     : _ptr(p) {
     validate();
   }
 
-  template <typename U = T, IF_MOVE_CONSTRUCTABLE(U)>
-  not_null (U &&p) NOEXCEPT_MOVE(U)
+  template <typename U = T, typename = std::enable_if_t<!std::is_lvalue_reference<U>::value && std::is_convertible<U &&, T>::value>>
+  constexpr not_null (U &&p) noexcept(std::is_nothrow_constructible<T, U &&>::value && checked_nothrow)
     : _ptr(std::move(p)) {
     validate();
   }
 
-  template <typename U = T, IF_COPY_CONSTRUCTABLE(U)>
-  not_null (const not_null<U> &p) NOEXCEPT_COPY(U)
-    : _ptr(p._ptr) {
-    validate();
-  }
+  constexpr not_null (const not_null &) = default;
+  constexpr not_null (not_null &&)      = default;
+  not_null &operator= (const not_null &) = default;
+  not_null &operator= (not_null &&)      = default;
+
+  template <typename U, typename P, typename = std::enable_if_t<std::is_convertible<const U &, T>::value>>
+  constexpr not_null (const not_null<U, P> &p) noexcept(std::is_nothrow_constructible<T, const U &>::value)
+    : _ptr(p._ptr) { }
 
-  template <typename U = T, IF_MOVE_CONSTRUCTABLE(U)>
-  not_null (not_null<U> &&p) NOEXCEPT_MOVE(U)
-    : _ptr(std::move(p._ptr)) {
+  template <typename U, typename P, typename = std::enable_if_t<std::is_convertible<U &&, T>::value>>
+  constexpr not_null (not_null<U, P> &&p) noexcept(std::is_nothrow_constructible<T, U &&>::value)
+    : _ptr(std::move(p._ptr)) { }
+
+  template <typename U, typename = std::enable_if_t<std::is_assignable<T &, const U &>::value>>
+  not_null &operator= (const U &cp) noexcept(std::is_nothrow_assignable<T &, const U &>::value && checked_nothrow) {
+    _ptr = cp;
     validate();
+    return *this;
   }
 
-  template <typename U = T, IF_COPY_CONSTRUCTABLE(U)>
-  not_null &operator= (const U &cp) NOEXCEPT_COPY(U) { _ptr = cp; validate(); return *this; }
-
-  template <typename U = T, IF_MOVE_CONSTRUCTABLE(U)>
-  not_null &operator= (U &&cp) NOEXCEPT_MOVE(U) { std::swap(_ptr, cp); validate(); return *this; }
+  template <typename U, typename P, typename = std::enable_if_t<std::is_assignable<T &, const U &>::value>>
+  not_null &operator= (const not_null<U, P> &cp) noexcept(std::is_nothrow_assignable<T &, const U &>::value) {
+    _ptr = cp._ptr;
+    return *this;
+  }
 
-  template <typename U = T, IF_COPY_CONSTRUCTABLE(U)>
-  not_null &operator= (const not_null<U> &cp) NOEXCEPT_COPY(U) { _ptr = cp._ptr; validate(); return *this; }
+  constexpr get_type get (void) const noexcept { return _ptr; }
 
-  template <typename U = T, IF_MOVE_CONSTRUCTABLE(U)>
-  not_null &operator= (not_null<U> &&cp) NOEXCEPT_MOVE(U) { std::swap(_ptr, cp._ptr); validate(); return *this; }
+  template <typename U, typename P>
+  constexpr bool operator == (const not_null<U, P> &other) const noexcept { return other.get() == get(); }
+  template <typename U, typename P>
+  constexpr bool operator != (const not_null<U, P> &other) const noexcept { return other.get() != get(); }
 
-  pointer get(void) const noexcept { return _ptr; }
+  constexpr explicit operator bool (void) const noexcept { return true; }
+  constexpr operator get_type (void) const noexcept { return get(); }
 
-  template <typename U>
-  bool     operator ==   (const not_null<U> &other) const noexcept { return other.get() == get(); }
+  constexpr decltype(auto) operator *  (void) const { return *_ptr; }
+  constexpr get_type       operator -> (void) const noexcept { return get(); }
 
-  explicit operator bool (void) const noexcept { return !!get(); }
-  auto     operator *    (void) const { return  *get(); }
-  pointer  operator ->   (void) const noexcept { return   get(); }
+  // Arithmetic would walk off the object, and nothing can make it null again.
+  not_null &operator++ (void) = delete;
+  not_null &operator-- (void) = delete;
+  not_null  operator++ (int)  = delete;
+  not_null  operator-- (int)  = delete;
+  not_null &operator+= (std::ptrdiff_t) = delete;
+  not_null &operator-= (std::ptrdiff_t) = delete;
 
 private:
-  void validate () { assert(_ptr != nullptr); }
+  template <class U, class P>
+  friend class not_null;
+
+  constexpr void validate (void) const {
+    if constexpr (!detail::is_unchecked<Policy>::value) {
+      if (detail::is_null(_ptr, 0)) { Policy::violation(); }
+    }
+  }
 
 private:
   T _ptr;
@@ -4,34 +4,80 @@
 #define OMTL_MEMORY_OWNER_H
 
 
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-#include <utils/mem/ptr.h>
+#include <omtl/mem/borrowed.h>
+#include <omtl/mem/ptr.h>
 
 
 namespace omtl {
 inline namespace mem {
 
 
-#ifndef OMTL_DEBUG_BORROWED_PTR
+namespace detail {
 
-/// @typedef template pointer type
-///          Used for borrowing from @ref{owned} pointer type.
-template <typename T>
-using borrowed = ptr<T>;
+/// @struct Owned pointer next to its deleter. A stateless deleter becomes
+///         a base class, so owner<T> stays the size of a raw pointer.
+template <typename P, typename D, bool = std::is_empty<D>::value && !std::is_final<D>::value>
+struct owner_pair : private D {
+  template <typename _D>
+  owner_pair(P p, _D &&d) noexcept : D(std::forward<_D>(d)), ptr(p) { }
 
-#else // OMTL_DEBUG_BORROWED_PTR
+  D       &deleter(void)       noexcept { return *this; }
+  const D &deleter(void) const noexcept { return *this; }
 
-template <typename T>
-struct borrowed;
+  P ptr;
+};
+
+template <typename P, typename D>
+struct owner_pair<P, D, false> {
+  template <typename _D>
+  owner_pair(P p, _D &&d) noexcept : ptr(p), del(std::forward<_D>(d)) { }
+
+  D       &deleter(void)       noexcept { return del; }
+  const D &deleter(void) const noexcept { return del; }
+
+  P ptr;
+  D del;
+};
+
+/// Target deleter for owner::as(): a per-type deleter `Del<T>` becomes
+/// `Del<U>` when it converts (arena_deleter upcasts), otherwise D is kept.
+template <typename D, typename U, typename = void>
+struct rebind_deleter { using type = D; };
+
+template <template <typename> class Del, typename T, typename U>
+struct rebind_deleter<Del<T>, U, std::enable_if_t<!std::is_same<Del<T>, std::default_delete<T>>::value &&
+                                                   std::is_constructible<Del<U>, Del<T> &&>::value>> {
+  using type = Del<U>;
+};
+
+template <typename T, typename U>
+struct rebind_deleter<std::default_delete<T>, U, void> { using type = std::default_delete<U>; };
 
-#endif // OMTL_DEBUG_BORROWED_PTR
+/// Deleter for owner::as(): std::default_delete has nothing to carry, and
+/// may not convert (as for downcasts); other deleters are converted.
+template <typename To, typename T>
+To cast_deleter(std::default_delete<T> &&) noexcept { return To(); }
+
+template <typename To, typename From>
+To cast_deleter(From &&d) noexcept { return To(std::forward<From>(d)); }
+
+}  // namespace detail
 
 
 /// @struct Owning pointer. Destroys the owned resource on delete.
 ///         Cannot be copied. Can be either moved or borrowed.
+///         The deleter is stored with the pointer, so it may carry state
+///         (e.g. the pool an object came from, see object_pool).
+///         With OMTL_DEBUG_BORROWED_PTR, borrows are checked and report use
+///         after the owner destroyed, reset or released the object.
 template <typename T, typename D = std::default_delete<T>>
-struct owner {
+struct owner : private detail::borrow_tracker {
 public:
   using element_type = T;
   using deleter_type = D;
@@ -39,29 +85,60 @@ public:
   using borrowed_type = borrowed<element_type>;
   using lvalue_type = typename std::add_lvalue_reference<element_type>::type;
 
-  explicit  owner(pointer p = nullptr)       noexcept : _ptr(p) { }
+  explicit  owner(pointer p = nullptr)       noexcept : _pair(p, deleter_type()) { }
+            owner(pointer p, const D &d)     noexcept : _pair(p, d) { }
+            owner(pointer p, D &&d)          noexcept : _pair(p, std::move(d)) { }
 
   ~owner(void) { reset(); }
 
-  owner(owner &&cp) noexcept { _ptr = cp.release(); }
+  owner(owner &&cp) noexcept : _pair(cp._take(), std::move(cp.get_deleter())) { adopt(cp); }
   owner(const owner &) = delete;
 
-  owner &operator= (owner &&cp) noexcept { std::swap(_ptr, cp._ptr); return *this; }
+  template <typename U, typename E,
+            typename = std::enable_if_t<std::is_convertible<ptr<U>, pointer>::value && std::is_convertible<E, D>::value>>
+  owner(owner<U, E> &&cp) noexcept : _pair(cp._take(), std::move(cp.get_deleter())) { adopt(cp); }
+
+  owner &operator= (owner &&cp) noexcept {
+    if (this != &cp) {
+      _delete();
+      _pair.ptr = cp._take();
+      adopt(cp);
+      get_deleter() = std::move(cp.get_deleter());
+    }
+    return *this;
+  }
   owner &operator= (const owner &) noexcept = delete;
 
-  template <typename U, typename _D = std::default_delete<U>>
-  owner<U, _D> as(void) { return owner<U, _D>(static_cast<U*>(release())); }
-
+  /// @brief Casts the owned pointer to U*. A std::default_delete becomes
+  ///        std::default_delete<U>; any other deleter is carried over as
+  ///        @p _D (rebound to U where it converts), so the object still goes
+  ///        back where it came from (e.g. its pool). A deleter unable to take
+  ///        U* does not compile.
+  template <typename U, typename _D = typename detail::rebind_deleter<D, U>::type>
+  owner<U, _D> as(void) {
+    static_assert(std::is_same<D, std::default_delete<T>>::value || std::is_constructible<_D, D &&>::value,
+                  "owner::as: the deleter must convert to the target deleter");
+    static_assert(std::is_invocable<_D &, ptr<U>>::value, "owner::as: the deleter must accept the cast pointer");
+    owner<U, _D> cast(static_cast<U*>(_take()), detail::cast_deleter<_D>(std::move(get_deleter())));
+    cast.adopt(*this);
+    return cast;
+  }
+
+  /// @brief Constructs the object in place, forwarding @p args untouched.
   template <typename ...Args>
-  static owner make(Args ...args) { return owner(new element_type(args...)); }
+  static owner make(Args &&...args) { return owner(new element_type(std::forward<Args>(args)...)); }
 
-  borrowed_type borrow(void) const noexcept;
+  /// @brief Non-owning pointer to the object. With OMTL_DEBUG_BORROWED_PTR
+  ///        the first borrow allocates the owner's slot, and may throw.
+  borrowed_type borrow(void) const OMTL_BORROW_NOEXCEPT;
 
-  deleter_type get_deleter(void) const noexcept { return deleter_type(); }
+  deleter_type       &get_deleter(void)       noexcept { return _pair.deleter(); }
+  const deleter_type &get_deleter(void) const noexcept { return _pair.deleter(); }
 
-  pointer get(void) const noexcept { return _ptr; }
-  pointer release(void) noexcept { pointer p = get(); _ptr = nullptr; return p; }
-  void    reset(pointer p = pointer()) noexcept { _delete(); _ptr = p; }
+  pointer get(void) const noexcept { return _pair.ptr; }
+  /// @brief Gives up the object; borrows taken so far become dangling.
+  pointer release(void) noexcept { retire(); return _take(); }
+  void    reset(pointer p = pointer()) noexcept { _delete(); _pair.ptr = p; }
 
   bool operator == (const owner &other) const noexcept { return other.get() == get(); }
   explicit operator bool(void) const noexcept { return !!get(); }
@@ -69,25 +146,108 @@ public:
   pointer     operator-> (void) const noexcept { return   get(); }
 
 private:
-  void _delete(void) noexcept { if (_ptr) { get_deleter()(_ptr); _ptr = nullptr; } }
+  template <typename, typename> friend struct owner;
+
+  pointer _take(void) noexcept { pointer p = get(); _pair.ptr = nullptr; return p; }
+  void    _delete(void) noexcept { if (pointer p = _take()) { retire(); get_deleter()(p); } }
+
+  detail::owner_pair<pointer, deleter_type> _pair;
+};
+
+
+/// @struct Deleter destroying and deallocating through a (rebound) allocator.
+///         Derives from the allocator, so stateless allocators take no space.
+template <typename Alloc>
+struct allocator_deleter : Alloc {
+  using traits = std::allocator_traits<Alloc>;
 
-  pointer _ptr;
+  static_assert(std::is_pointer<typename traits::pointer>::value, "owner does not hold fancy pointers");
+
+  allocator_deleter(void) = default;
+  explicit allocator_deleter(const Alloc &a) noexcept : Alloc(a) { }
+
+  void operator()(typename traits::pointer p) noexcept {
+    Alloc &alloc = *this;
+    traits::destroy(alloc, p);
+    traits::deallocate(alloc, p, 1);
+  }
+};
+
+
+/// @brief Constructs a @p T with memory from @p alloc (rebound to T):
+///        one allocation, arguments forwarded to the constructor.
+template <typename T, typename Alloc, typename ...Args>
+auto allocate_owner(const Alloc &alloc, Args &&...args)
+  -> owner<T, allocator_deleter<typename std::allocator_traits<Alloc>::template rebind_alloc<T>>> {
+  using alloc_type = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using traits     = std::allocator_traits<alloc_type>;
+
+  alloc_type a(alloc);
+  const auto p = traits::allocate(a, 1);
+  try {
+    traits::construct(a, p, std::forward<Args>(args)...);
+  } catch (...) {
+    traits::deallocate(a, p, 1);
+    throw;
+  }
+  return owner<T, allocator_deleter<alloc_type>>(p, allocator_deleter<alloc_type>(a));
+}
+
+
+namespace detail {
+
+template <typename T, typename E>
+struct trailing_layout {
+  static constexpr size_t align  = alignof(T) > alignof(E) ? alignof(T) : alignof(E);
+  static constexpr size_t offset = (sizeof(T) + alignof(E) - 1) / alignof(E) * alignof(E);
 };
 
+}  // namespace detail
 
-#ifdef DEBUG_BORROWED_PTR
 
-/// @todo: Add debug impl
+/// @struct Deleter for objects made by make_trailing<T, E>().
+template <typename T, typename E>
+struct trailing_deleter {
+  void operator()(ptr<T> p) const noexcept {
+    p->~T();
+    ::operator delete(static_cast<void *>(p), std::align_val_t(detail::trailing_layout<T, E>::align));
+  }
+};
+
+
+/// @brief Constructs a @p T followed, in the same allocation, by @p count
+///        uninitialized elements of @p E, reachable with trailing_data<E>().
+///        Suited to nodes with variable-size payloads (names, keys, buffers).
+template <typename T, typename E = unsigned char, typename ...Args>
+owner<T, trailing_deleter<T, E>> make_trailing(size_t count, Args &&...args) {
+  static_assert(std::is_trivially_default_constructible<E>::value && std::is_trivially_destructible<E>::value,
+                "trailing elements are neither constructed nor destroyed");
+  using layout = detail::trailing_layout<T, E>;
+
+  void *raw = ::operator new(layout::offset + count * sizeof(E), std::align_val_t(layout::align));
+  try {
+    return owner<T, trailing_deleter<T, E>>(::new (raw) T(std::forward<Args>(args)...));
+  } catch (...) {
+    ::operator delete(raw, std::align_val_t(layout::align));
+    throw;
+  }
+}
+
+/// @brief First trailing element of an object made by make_trailing<T, E>().
+template <typename E, typename T>
+ptr<E> trailing_data(ptr<T> obj) noexcept {
+  return reinterpret_cast<ptr<E>>(reinterpret_cast<ptr<unsigned char>>(obj) + detail::trailing_layout<T, E>::offset);
+}
+
+template <typename E, typename T>
+cptr<E> trailing_data(cptr<T> obj) noexcept {
+  return reinterpret_cast<cptr<E>>(reinterpret_cast<cptr<unsigned char>>(obj) + detail::trailing_layout<T, E>::offset);
+}
 
-#endif // DEBUG_BORROWED_PTR
 
 template <typename T, typename D>
-auto owner<T, D>::borrow(void) const noexcept -> typename owner<T, D>::borrowed_type {
-#ifndef DEBUG_BORROWED_PTR
-  return get();
-#else // DEBUG_BORROWED_PTR
-  /// @todo: Add debug impl
-#endif // DEBUG_BORROWED_PTR
+auto owner<T, D>::borrow(void) const OMTL_BORROW_NOEXCEPT -> typename owner<T, D>::borrowed_type {
+  return lend(get());
 }
 
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#ifndef OMTL_MEMORY_POOL_H
+#define OMTL_MEMORY_POOL_H
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <omtl/mem/owner.h>
+
+
+namespace omtl {
+inline namespace mem {
+
+
+template <typename T>
+class object_pool;
+
+
+/// @struct Deleter handing an object back to the object_pool it came from.
+template <typename T>
+struct pool_deleter {
+  pool_deleter(void) noexcept = default;
+  explicit pool_deleter(object_pool<T> *p) noexcept : pool(p) { }
+
+  void operator()(ptr<T> p) const noexcept { pool->destroy(p); }
+
+  object_pool<T> *pool = nullptr;
+};
+
+
+/// @class Free-list pool of fixed-size slots for objects of type @p T.
+///        Slots come from chunks growing geometrically from @p chunk up to
+///        @p max_chunk objects; freed slots are reused last-in first-out, so
+///        a churning workload keeps touching the same warm cache lines.
+///        Chunks are only released with the pool, which must outlive every
+///        object it handed out. Not thread-safe.
+template <typename T>
+class object_pool {
+public:
+  using element_type = T;
+  using deleter_type = pool_deleter<T>;
+  using owner_type   = owner<T, deleter_type>;
+
+  explicit object_pool(size_t chunk = 64, size_t max_chunk = 4096)
+    : _next_chunk(std::max<size_t>(chunk, 1)), _max_chunk(std::max(max_chunk, _next_chunk)) { }
+
+  ~object_pool(void) { assert(_live == 0 && "object_pool destroyed with live objects"); }
+
+  object_pool(const object_pool &) = delete;
+  object_pool &operator= (const object_pool &) = delete;
+
+  /// @brief Constructs a T in a pooled slot; the owner returns it on reset.
+  template <typename ...Args>
+  owner_type make(Args &&...args) {
+    return owner_type(construct(std::forward<Args>(args)...), deleter_type(this));
+  }
+
+  template <typename ...Args>
+  ptr<T> construct(Args &&...args) {
+    void *slot = allocate();
+    try {
+      return ::new (slot) T(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(slot);
+      throw;
+    }
+  }
+
+  void destroy(ptr<T> p) noexcept {
+    p->~T();
+    deallocate(p);
+  }
+
+  /// @brief Raw uninitialized slot, sized and aligned for one T.
+  void *allocate(void) {
+    if (!_free) { grow(_next_chunk); }
+    slot_t *slot = _free;
+    _free = slot->next;
+    ++_live;
+    return slot->object;
+  }
+
+  void deallocate(void *p) noexcept {
+    assert(_live > 0);
+    slot_t *slot = reinterpret_cast<slot_t *>(p);
+    slot->next = _free;
+    _free = slot;
+    --_live;
+  }
+
+  /// @brief Makes room for @p n live objects without further allocation.
+  void reserve(size_t n) {
+    if (n > _capacity) { grow(n - _capacity); }
+  }
+
+  size_t size    (void) const noexcept { return _live; }
+  size_t capacity(void) const noexcept { return _capacity; }
+
+private:
+  union slot_t {
+    slot_t *next;
+    alignas(T) unsigned char object[sizeof(T)];
+  };
+
+  void grow(size_t n) {
+    std::unique_ptr<slot_t[]> chunk(new slot_t[n]);
+    for (size_t i = n; i-- > 0;) {
+      chunk[i].next = _free;
+      _free = &chunk[i];
+    }
+    _chunks.push_back(std::move(chunk));
+    _capacity += n;
+    _next_chunk = std::min(_next_chunk * 2, _max_chunk);
+  }
+
+  std::vector<std::unique_ptr<slot_t[]>> _chunks;
+  slot_t *_free       = nullptr;
+  size_t  _next_chunk;
+  size_t  _max_chunk;
+  size_t  _live       = 0;
+  size_t  _capacity   = 0;
+};
+
+
+}  // inline namespace mem
+}  // namespace omtl
+
+#endif  // OMTL_MEMORY_POOL_H
@@ -0,0 +1,144 @@
+#pragma once
+
+#ifndef OMTL_MEMORY_SHARED_H
+#define OMTL_MEMORY_SHARED_H
+
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <omtl/mem/borrowed.h>
+#include <omtl/mem/owner.h>
+#include <omtl/mem/ptr.h>
+
+
+namespace omtl {
+inline namespace mem {
+
+
+/// @struct Reference count policy for objects shared between threads.
+struct atomic_refcount {
+  using counter = std::atomic<uint32_t>;
+
+  /// @brief The first reference comes from whoever holds the object
+  ///        unshared, so it is a plain store.
+  static void increment(counter &c) noexcept {
+    if (c.load(std::memory_order_relaxed) == 0) { c.store(1, std::memory_order_relaxed); }
+    else                                        { c.fetch_add(1, std::memory_order_relaxed); }
+  }
+
+  /// @return Whether the last reference went away. The sole holder has
+  ///         nobody to race with, so it skips the locked instruction.
+  static bool decrement(counter &c) noexcept {
+    return c.load(std::memory_order_acquire) == 1 || c.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  static uint32_t load(const counter &c) noexcept { return c.load(std::memory_order_relaxed); }
+};
+
+/// @struct Reference count policy for objects that never leave their thread:
+///         plain increments, no lock prefix, no fences.
+struct local_refcount {
+  using counter = uint32_t;
+
+  static void     increment(counter &c) noexcept { ++c; }
+  static bool     decrement(counter &c) noexcept { return --c == 0; }
+  static uint32_t load(const counter &c) noexcept { return c; }
+};
+
+
+/// @struct Base embedding the reference count in the object itself:
+///         struct message : omtl::ref_counted<message> { ... };
+///         The count is 4 bytes inside the object and needs no
+///         separate control block. Objects are destroyed through
+///         Derived, so classes deriving further need a virtual destructor.
+template <typename Derived, typename Policy = atomic_refcount>
+struct ref_counted {
+public:
+  using refcount_policy = Policy;
+
+  uint32_t use_count(void) const noexcept { return Policy::load(_refs); }
+
+protected:
+  ref_counted(void) noexcept = default;
+  ref_counted(const ref_counted &) noexcept { }  // A copy is a new object, unshared.
+  ref_counted &operator= (const ref_counted &) noexcept { return *this; }
+  ~ref_counted(void) = default;
+
+private:
+  friend void omtl_add_ref(const ref_counted *p) noexcept { Policy::increment(p->_refs); }
+
+  friend void omtl_release(const ref_counted *p) noexcept {
+    if (Policy::decrement(p->_refs)) { delete static_cast<const Derived *>(p); }
+  }
+
+  mutable typename Policy::counter _refs{ 0 };
+};
+
+
+/// @class Intrusive shared pointer. Copies bump the count stored in the
+///        object through the omtl_add_ref / omtl_release pair found by
+///        argument-dependent lookup; ref_counted provides both, and types
+///        with their own count can define them instead.
+template <typename T>
+class shared {
+public:
+  using element_type  = T;
+  using pointer       = ptr<T>;
+  using borrowed_type = borrowed<element_type>;
+  using lvalue_type   = typename std::add_lvalue_reference<element_type>::type;
+
+  shared(void) noexcept = default;
+  shared(std::nullptr_t) noexcept { }
+
+  /// @brief Shares @p p, adding a reference to those it already has.
+  explicit shared(pointer p) noexcept : _ptr(p) { if (_ptr) { omtl_add_ref(_ptr); } }
+
+  /// @brief Takes over an owned object in place: no allocation, no copy.
+  template <typename U, typename = std::enable_if_t<std::is_convertible<ptr<U>, pointer>::value>>
+  shared(owner<U> &&o) noexcept : shared(static_cast<pointer>(o.release())) { }
+
+  shared(const shared &cp) noexcept : shared(cp._ptr) { }
+  shared(shared &&cp) noexcept : _ptr(cp._ptr) { cp._ptr = nullptr; }
+
+  template <typename U, typename = std::enable_if_t<std::is_convertible<ptr<U>, pointer>::value>>
+  shared(const shared<U> &cp) noexcept : shared(static_cast<pointer>(cp.get())) { }
+
+  template <typename U, typename = std::enable_if_t<std::is_convertible<ptr<U>, pointer>::value>>
+  shared(shared<U> &&cp) noexcept : _ptr(cp._ptr) { cp._ptr = nullptr; }
+
+  ~shared(void) { if (_ptr) { omtl_release(_ptr); } }
+
+  shared &operator= (const shared &cp) noexcept { shared(cp).swap(*this); return *this; }
+  shared &operator= (shared &&cp) noexcept { shared(std::move(cp)).swap(*this); return *this; }
+
+  /// @brief Constructs the object in place and shares it.
+  template <typename ...Args>
+  static shared make(Args &&...args) { return shared(new element_type(std::forward<Args>(args)...)); }
+
+  borrowed_type borrow(void) const noexcept { return _ptr; }
+
+  pointer get(void) const noexcept { return _ptr; }
+  void    reset(void) noexcept { shared().swap(*this); }
+  void    swap(shared &o) noexcept { std::swap(_ptr, o._ptr); }
+
+  bool operator == (const shared &other) const noexcept { return other._ptr == _ptr; }
+  bool operator != (const shared &other) const noexcept { return other._ptr != _ptr; }
+  explicit operator bool(void) const noexcept { return !!_ptr; }
+  lvalue_type operator*  (void) const { return *_ptr; }
+  pointer     operator-> (void) const noexcept { return _ptr; }
+
+private:
+  template <typename U> friend class shared;
+
+  pointer _ptr = nullptr;
+};
+
+
+}  // inline namespace mem
+}  // namespace omtl
+
+#endif  // OMTL_MEMORY_SHARED_H
@@ -0,0 +1,205 @@
+#pragma once
+
+#ifndef OMTL_MEMORY_SLOT_MAP_H
+#define OMTL_MEMORY_SLOT_MAP_H
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <omtl/mem/borrowed.h>
+#include <omtl/mem/ptr.h>
+
+
+namespace omtl {
+inline namespace mem {
+
+
+/// @class Generational handle into a slot_map<T>: a slot index and the
+///        generation of the slot when the element was inserted. Erasing
+///        the element bumps the generation, so old handles stop resolving
+///        instead of reaching whatever reuses the slot. The default handle
+///        refers to nothing.
+template <typename T>
+class slot_handle {
+public:
+  slot_handle (void) noexcept = default;
+
+  uint32_t index      (void) const noexcept { return _index; }
+  uint32_t generation (void) const noexcept { return _generation; }
+
+  explicit operator bool (void) const noexcept { return _generation != 0; }
+
+  bool operator == (const slot_handle &o) const noexcept { return _index == o._index && _generation == o._generation; }
+  bool operator != (const slot_handle &o) const noexcept { return !(*this == o); }
+
+private:
+  template <typename> friend class slot_map;
+
+  slot_handle (uint32_t index, uint32_t generation) noexcept : _index(index), _generation(generation) { }
+
+  uint32_t _index      = 0;
+  uint32_t _generation = 0;
+};
+
+
+/// @class Container handing out generational handles. Elements sit densely
+///        in one vector, so iterating is a linear scan; handles resolve to
+///        them through a slot table, so insert, erase and lookup are O(1)
+///        and erasing moves the last element into the hole. Pointers and
+///        borrows are valid until the next insert or erase; handles stay
+///        valid until their element is erased.
+template <typename T>
+class slot_map {
+public:
+  using value_type     = T;
+  using handle         = slot_handle<T>;
+  using iterator       = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  slot_map (void) = default;
+
+  template <typename ...Args>
+  handle emplace (Args &&...args);
+
+  handle insert (const T &value) { return emplace(value); }
+  handle insert (T &&value)      { return emplace(std::move(value)); }
+
+  /// @return Whether @p h still referred to an element.
+  bool erase (handle h);
+
+  bool    contains (handle h) const noexcept { return find(h) != nullptr; }
+  ptr<T>  find     (handle h)       noexcept { return live(h) ? &_values[_slots[h._index].dense] : nullptr; }
+  cptr<T> find     (handle h) const noexcept { return live(h) ? &_values[_slots[h._index].dense] : nullptr; }
+
+  /// @brief Borrow of the element of @p h, null when @p h is stale.
+  borrowed<T> borrow (handle h) noexcept { return find(h); }
+
+  T       &operator[] (handle h)       noexcept { assert(live(h)); return _values[_slots[h._index].dense]; }
+  const T &operator[] (handle h) const noexcept { assert(live(h)); return _values[_slots[h._index].dense]; }
+
+  /// @brief Handle of the element at position @p i of the iteration order.
+  handle handle_at (size_t i) const noexcept {
+    const uint32_t slot = _owners[i];
+    return handle(slot, _slots[slot].generation);
+  }
+
+  iterator       begin (void)       noexcept { return _values.begin(); }
+  iterator       end   (void)       noexcept { return _values.end(); }
+  const_iterator begin (void) const noexcept { return _values.begin(); }
+  const_iterator end   (void) const noexcept { return _values.end(); }
+
+  ptr<T>  data (void)       noexcept { return _values.data(); }
+  cptr<T> data (void) const noexcept { return _values.data(); }
+
+  size_t size  (void) const noexcept { return _values.size(); }
+  bool   empty (void) const noexcept { return _values.empty(); }
+
+  void reserve (size_t n);
+
+  /// @brief Erases every element; all handles handed out go stale.
+  void clear (void);
+
+private:
+  static constexpr uint32_t no_slot = UINT32_MAX;
+
+  /// Live slots point at their element, free ones at the next free slot.
+  struct slot_t {
+    uint32_t dense;
+    uint32_t generation;
+  };
+
+  bool live (handle h) const noexcept {
+    return h._index < _slots.size() && _slots[h._index].generation == h._generation && h._generation != 0;
+  }
+
+  void retire (uint32_t slot) noexcept {
+    slot_t &s = _slots[slot];
+    s.generation = s.generation + 1 ? s.generation + 1 : 1;  // 0 is the null handle.
+    s.dense = _free;
+    _free = slot;
+  }
+
+  std::vector<T>        _values;
+  std::vector<uint32_t> _owners;  ///< Slot of each element, parallel to _values.
+  std::vector<slot_t>   _slots;
+  uint32_t              _free = no_slot;
+};
+
+
+template <typename T>
+template <typename ...Args>
+typename slot_map<T>::handle slot_map<T>::emplace (Args &&...args) {
+  if (_free == no_slot) {
+    assert(_slots.size() < no_slot);
+    _slots.push_back({ no_slot, 1 });
+    _free = static_cast<uint32_t>(_slots.size() - 1);
+  }
+  const uint32_t slot = _free;
+  _owners.push_back(slot);
+  try {
+    _values.emplace_back(std::forward<Args>(args)...);
+  } catch (...) {
+    _owners.pop_back();
+    throw;
+  }
+  _free = _slots[slot].dense;
+  _slots[slot].dense = static_cast<uint32_t>(_values.size() - 1);
+  return handle(slot, _slots[slot].generation);
+}
+
+
+template <typename T>
+bool slot_map<T>::erase (handle h) {
+  if (!live(h)) { return false; }
+
+  const uint32_t hole = _slots[h._index].dense;
+  const uint32_t last = static_cast<uint32_t>(_values.size() - 1);
+  if (hole != last) {
+    _values[hole] = std::move(_values[last]);
+    _owners[hole] = _owners[last];
+    _slots[_owners[hole]].dense = hole;
+  }
+  _values.pop_back();
+  _owners.pop_back();
+  retire(h._index);
+  return true;
+}
+
+
+template <typename T>
+void slot_map<T>::reserve (size_t n) {
+  _values.reserve(n);
+  _owners.reserve(n);
+  _slots.reserve(n);
+}
+
+
+template <typename T>
+void slot_map<T>::clear (void) {
+  for (uint32_t slot : _owners) { retire(slot); }
+  _values.clear();
+  _owners.clear();
+}
+
+
+}  // inline namespace mem
+}  // namespace omtl
+
+
+namespace std {
+
+template <typename T>
+struct hash<omtl::slot_handle<T>> {
+  size_t operator() (const omtl::slot_handle<T> &h) const noexcept {
+    return std::hash<uint64_t>()(uint64_t(h.generation()) << 32 | h.index());
+  }
+};
+
+}  // namespace std
+
+#endif  // OMTL_MEMORY_SLOT_MAP_H
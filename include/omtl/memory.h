@@ -10,6 +10,10 @@
 #include <omtl/mem/ptr.h>
 #include <omtl/mem/not_null.h>
 #include <omtl/mem/owner.h>
+#include <omtl/mem/pool.h>
+#include <omtl/mem/arena.h>
+#include <omtl/mem/shared.h>
+#include <omtl/mem/slot_map.h>
 
 
 #endif  // OMTL_MEMORY_H
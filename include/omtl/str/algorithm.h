@@ -4,10 +4,15 @@
 #define OMTL_STR_ALGORITHM_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <vector>
 
+#include <omtl/utils/cpu.h>
 #include <omtl/utils/flags.h>
-#include <omtl/str/string_view.h>
+#include <omtl/str/charset.h>
+#include <omtl/str/view.h>
 
 
 namespace omtl {
@@ -23,55 +28,304 @@ enum class split_opt {
 using split_flags = omtl::flags<split_opt>;
 
 
-template <class ResultContainer, class CharT, class Traits>
-ResultContainer split (basic_view<CharT, Traits> str, basic_view<CharT, Traits> delim, split_flags flags = split_flags())
-{
-  ResultContainer ret;
+namespace detail {
+
+template <class CharT, class Traits>
+struct view_delimiter {
+  basic_view<CharT, Traits> delim;
+
+  size_t find   (basic_view<CharT, Traits> str, size_t from) const noexcept {
+    return delim.empty() ? basic_view<CharT, Traits>::npos : str.find(delim, from);
+  }
+  size_t length (void) const noexcept { return delim.size(); }
+};
+
+template <class CharT, class Traits>
+struct char_delimiter {
+  CharT delim;
+
+  size_t find   (basic_view<CharT, Traits> str, size_t from) const noexcept { return str.find(delim, from); }
+  size_t length (void) const noexcept { return 1; }
+};
+
+template <class CharT, class Traits>
+struct set_delimiter {
+  basic_charset<CharT, Traits> delims;
+
+  size_t find   (basic_view<CharT, Traits> str, size_t from) const noexcept { return find_first_of(str, delims, from); }
+  size_t length (void) const noexcept { return 1; }
+};
+
+}  // namespace detail
+
+
+/// @class Lazy tokenizer over a view. Tokens are produced on demand while
+///        iterating, so nothing is allocated and the caller may stop early.
+///        Tokens point into the split string, which must outlive the range.
+///        After @p max_splits tokens the rest of the string is yielded whole.
+template <class CharT, class Traits = std::char_traits<CharT>,
+          class Delim = detail::view_delimiter<CharT, Traits>>
+class split_range {
+public:
+  using view_type = basic_view<CharT, Traits>;
+
+  static constexpr size_t unlimited = size_t(-1);
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = view_type;
+    using difference_type   = ptrdiff_t;
+    using pointer           = const view_type *;
+    using reference         = const view_type &;
+
+    iterator (void) noexcept = default;
+
+    reference operator *  (void) const noexcept { return  _token; }
+    pointer   operator -> (void) const noexcept { return &_token; }
+
+    iterator &operator ++ (void) { advance(); return *this; }
+    iterator  operator ++ (int)  { iterator cp(*this); advance(); return cp; }
+
+    bool operator == (const iterator &o) const noexcept {
+      return _range == o._range && (!_range || _token.data() == o._token.data());
+    }
+    bool operator != (const iterator &o) const noexcept { return !(*this == o); }
 
-  size_t start = 0;
-  size_t pos = 0;
-  while (pos < str.length()) {
-    pos = std::min(str.length(), str.find(delim, start));
-    if (!flags.test(split_opt::skip_empty) || pos != start) {
-      ret.push_back(str.substr(start, pos - start));
+  private:
+    friend class split_range;
+
+    explicit iterator (const split_range *range)
+      : _range(range), _next(range->_str.empty() ? view_type::npos : 0) {
+      advance();
+    }
+
+    void advance (void) {
+      const view_type &str = _range->_str;
+      const Delim     &delim = _range->_delim;
+      const size_t     step  = delim.length();
+      while (_next != view_type::npos) {
+        const size_t start = _next;
+        size_t pos;
+        if (_emitted < _range->_max_splits) {
+          pos = std::min(str.size(), delim.find(str, start));
+        } else if (_range->_skip_empty && step && start < str.size() && delim.find(str, start) == start) {
+          _next = start + step;
+          continue;
+        } else {
+          pos = str.size();
+        }
+        _next = pos < str.size() ? pos + step : view_type::npos;
+        if (!_range->_skip_empty || pos != start) {
+          _token = view_type(str.data() + start, pos - start);
+          ++_emitted;
+          return;
+        }
+      }
+      _range = nullptr;
     }
-    start = pos + delim.length();
+
+    const split_range *_range   = nullptr;
+    size_t             _next    = view_type::npos;
+    size_t             _emitted = 0;
+    view_type          _token;
+  };
+
+  split_range (view_type str, Delim delim, split_flags flags = split_flags(), size_t max_splits = unlimited)
+    : _str(str)
+    , _delim(std::move(delim))
+    , _max_splits(max_splits)
+    , _skip_empty(flags.test(split_opt::skip_empty))
+  { }
+
+  iterator begin (void) const { return iterator(this); }
+  iterator end   (void) const noexcept { return iterator(); }
+
+private:
+  view_type _str;
+  Delim     _delim;
+  size_t    _max_splits;
+  bool      _skip_empty;
+};
+
+
+template <class CharT, class Traits>
+split_range<CharT, Traits>
+lazy_split (basic_view<CharT, Traits> str, basic_view<CharT, Traits> delim,
+            split_flags flags = split_flags(), size_t max_splits = size_t(-1)) {
+  return split_range<CharT, Traits>(str, { delim }, flags, max_splits);
+}
+
+/// @brief Splits on a single character; the scan is Traits::find, i.e. memchr for char.
+template <class CharT, class Traits>
+split_range<CharT, Traits, detail::char_delimiter<CharT, Traits>>
+lazy_split (basic_view<CharT, Traits> str, CharT delim,
+            split_flags flags = split_flags(), size_t max_splits = size_t(-1)) {
+  return split_range<CharT, Traits, detail::char_delimiter<CharT, Traits>>(str, { delim }, flags, max_splits);
+}
+
+/// @brief Splits on any character of @p delims, e.g. ",;" or " \t".
+template <class CharT, class Traits>
+split_range<CharT, Traits, detail::set_delimiter<CharT, Traits>>
+lazy_split (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &delims,
+            split_flags flags = split_flags(), size_t max_splits = size_t(-1)) {
+  return split_range<CharT, Traits, detail::set_delimiter<CharT, Traits>>(str, { delims }, flags, max_splits);
+}
+
+
+template <class ResultContainer, class CharT, class Traits, class Delim>
+ResultContainer split (basic_view<CharT, Traits> str, const Delim &delim,
+                       split_flags flags = split_flags(), size_t max_splits = size_t(-1))
+{
+  ResultContainer ret;
+  for (basic_view<CharT, Traits> token : lazy_split(str, delim, flags, max_splits)) {
+    ret.push_back(token);
   }
   return ret;
 }
 
 
 template <class CharT, class Traits>
-bool starts_with (basic_view<CharT, Traits> str, basic_view<CharT, Traits> prefix) {
-  return Traits::compare(str.data(), prefix.data(), prefix.length()) == 0;
+constexpr bool starts_with (basic_view<CharT, Traits> str, basic_view<CharT, Traits> prefix) noexcept {
+  return prefix.size() <= str.size() && Traits::compare(str.data(), prefix.data(), prefix.size()) == 0;
 }
 
+template <class CharT, class Traits>
+constexpr bool ends_with (basic_view<CharT, Traits> str, basic_view<CharT, Traits> suffix) noexcept {
+  return suffix.size() <= str.size() &&
+         Traits::compare(str.data() + str.size() - suffix.size(), suffix.data(), suffix.size()) == 0;
+}
 
-#define WHITESPACE_CHARS " \t\n\r"
 
-template<class CharT, class Traits>
-basic_view<CharT, Traits> ltrim (basic_view<CharT, Traits> str, const CharT *skipped = WHITESPACE_CHARS) {
-  std::string_view v = str;
-  v.remove_prefix(std::min(v.find_first_not_of(skipped), v.size()));
-  return v;
+/// @brief Set-based scans usable with either basic_view implementation;
+///        the std::basic_string_view alias cannot take a charset member.
+template <class CharT, class Traits>
+size_t find_first_of (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &set, size_t pos = 0) {
+  if (pos >= str.size()) { return basic_view<CharT, Traits>::npos; }
+  size_t found = set.find_first_of(str.data() + pos, str.size() - pos);
+  return found == basic_view<CharT, Traits>::npos ? found : pos + found;
+}
+
+template <class CharT, class Traits>
+size_t find_first_not_of (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &set, size_t pos = 0) {
+  if (pos >= str.size()) { return basic_view<CharT, Traits>::npos; }
+  size_t found = set.find_first_not_of(str.data() + pos, str.size() - pos);
+  return found == basic_view<CharT, Traits>::npos ? found : pos + found;
+}
+
+template <class CharT, class Traits>
+size_t find_last_of (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &set,
+                     size_t pos = basic_view<CharT, Traits>::npos) {
+  if (str.empty()) { return basic_view<CharT, Traits>::npos; }
+  return set.find_last_of(str.data(), std::min(pos, str.size() - 1) + 1);
+}
+
+template <class CharT, class Traits>
+size_t find_last_not_of (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &set,
+                         size_t pos = basic_view<CharT, Traits>::npos) {
+  if (str.empty()) { return basic_view<CharT, Traits>::npos; }
+  return set.find_last_not_of(str.data(), std::min(pos, str.size() - 1) + 1);
+}
+
+
+template <class CharT, class Traits = std::char_traits<CharT>>
+const basic_charset<CharT, Traits> &whitespace (void) {
+  static const CharT chars[] = { CharT(' '), CharT('\t'), CharT('\n'), CharT('\r') };
+  static const basic_charset<CharT, Traits> set(chars, sizeof(chars) / sizeof(chars[0]));
+  return set;
 }
 
 
 template<class CharT, class Traits>
-basic_view<CharT, Traits> rtrim (basic_view<CharT, Traits> str, const CharT *skipped = WHITESPACE_CHARS) {
-  std::string_view v = str;
-  int valid = std::max((int)(v.find_last_not_of(skipped)) + 1, 0);
-  v.remove_suffix(v.size() - valid);
-  return v;
+basic_view<CharT, Traits> ltrim (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &skipped) {
+  str.remove_prefix(std::min(find_first_not_of(str, skipped), str.size()));
+  return str;
 }
 
+template<class CharT, class Traits>
+basic_view<CharT, Traits> rtrim (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &skipped) {
+  size_t last = find_last_not_of(str, skipped);
+  str.remove_suffix(last == basic_view<CharT, Traits>::npos ? str.size() : str.size() - last - 1);
+  return str;
+}
 
 template<class CharT, class Traits>
-basic_view<CharT, Traits> trim (basic_view<CharT, Traits> str, const CharT *skipped = WHITESPACE_CHARS) {
+basic_view<CharT, Traits> trim (basic_view<CharT, Traits> str, const basic_charset<CharT, Traits> &skipped) {
   return ltrim(rtrim(str, skipped), skipped);
 }
 
-#undef WHITESPACE_CHARS
+
+namespace detail {
+
+template <class CharT>
+struct whitespace_chars {
+  static constexpr CharT value[] = { CharT(' '), CharT('\t'), CharT('\n'), CharT('\r') };
+};
+
+template <class CharT>
+constexpr CharT whitespace_chars<CharT>::value[];
+
+/// Trimming for constant evaluation, through the view's scalar scans.
+template <class CharT, class Traits>
+constexpr basic_view<CharT, Traits> trim_scalar (basic_view<CharT, Traits> str, basic_view<CharT, Traits> skipped,
+                                                 bool left, bool right) noexcept {
+  if (right) {
+    const size_t last = str.find_last_not_of(skipped);
+    str.remove_suffix(last == basic_view<CharT, Traits>::npos ? str.size() : str.size() - last - 1);
+  }
+  if (left) {
+    str.remove_prefix(std::min(str.find_first_not_of(skipped), str.size()));
+  }
+  return str;
+}
+
+template <class CharT, class Traits>
+constexpr basic_view<CharT, Traits> whitespace_view (void) noexcept {
+  return basic_view<CharT, Traits>(whitespace_chars<CharT>::value, 4);
+}
+
+}  // namespace detail
+
+
+// The overloads without a prebuilt charset also work in constant expressions.
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> ltrim (basic_view<CharT, Traits> str) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, detail::whitespace_view<CharT, Traits>(), true, false); }
+  return ltrim(str, whitespace<CharT, Traits>());
+}
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> rtrim (basic_view<CharT, Traits> str) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, detail::whitespace_view<CharT, Traits>(), false, true); }
+  return rtrim(str, whitespace<CharT, Traits>());
+}
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> trim (basic_view<CharT, Traits> str) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, detail::whitespace_view<CharT, Traits>(), true, true); }
+  return trim(str, whitespace<CharT, Traits>());
+}
+
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> ltrim (basic_view<CharT, Traits> str, const CharT *skipped) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, basic_view<CharT, Traits>(skipped), true, false); }
+  return ltrim(str, basic_charset<CharT, Traits>(skipped));
+}
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> rtrim (basic_view<CharT, Traits> str, const CharT *skipped) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, basic_view<CharT, Traits>(skipped), false, true); }
+  return rtrim(str, basic_charset<CharT, Traits>(skipped));
+}
+
+template<class CharT, class Traits>
+constexpr basic_view<CharT, Traits> trim (basic_view<CharT, Traits> str, const CharT *skipped) {
+  if (cpu::constant_evaluated()) { return detail::trim_scalar(str, basic_view<CharT, Traits>(skipped), true, true); }
+  return trim(str, basic_charset<CharT, Traits>(skipped));
+}
+
 
 }  // namespace str
 }  // namespace omtl
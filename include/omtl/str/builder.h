@@ -0,0 +1,181 @@
+#pragma once
+
+#ifndef OMTL_STR_BUILDER_H
+#define OMTL_STR_BUILDER_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define OMTL_HAVE_WRITEV 1
+#  include <sys/uio.h>
+#endif
+
+#include <omtl/mem/owner.h>
+#include <omtl/str/view.h>
+#include <omtl/str/storage.h>
+
+
+namespace omtl {
+namespace str {
+
+
+/// @class Rope of views to be written out once. append() records a piece
+///        without copying it, so it must outlive the builder; append_copy()
+///        first copies it into storage blocks, either the builder's own or
+///        a storage passed in. Pieces adjacent in memory are merged, so runs
+///        of copies usually collapse into one. The total length is kept up
+///        to date, so str() allocates exactly once, and to_iovec() hands the
+///        pieces to writev() without building the string at all.
+template <class CharT, class Traits = std::char_traits<CharT>>
+class basic_string_builder {
+public:
+  using view_type    = basic_view<CharT, Traits>;
+  using storage_type = storage<CharT, Traits>;
+  using size_type    = size_t;
+
+  using const_iterator = typename std::vector<view_type>::const_iterator;
+
+  static constexpr size_type default_block = 4096;
+
+  basic_string_builder (void) = default;
+  /// @brief Builder copying into @p copies, which must outlive the output.
+  explicit basic_string_builder (storage_type &copies) noexcept : _copies(&copies) { }
+
+  basic_string_builder (basic_string_builder &&) = default;
+  basic_string_builder &operator= (basic_string_builder &&) = default;
+
+  basic_string_builder (const basic_string_builder &) = delete;
+  basic_string_builder &operator= (const basic_string_builder &) = delete;
+
+  basic_string_builder &append (view_type piece) {
+    if (piece.empty()) { return *this; }
+    _size += piece.size();
+    if (pieces() != 0) {
+      view_type &last = _pieces.back();
+      if (last.data() + last.size() == piece.data()) {
+        last = view_type(last.data(), last.size() + piece.size());
+        return *this;
+      }
+    }
+    _pieces.push_back(piece);
+    return *this;
+  }
+
+  /// @brief Appends a copy of @p piece, for temporaries.
+  basic_string_builder &append_copy (view_type piece) {
+    if (piece.empty()) { return *this; }
+    CharT *copy = copies().allocate(piece.size());
+    Traits::copy(copy, piece.data(), piece.size());
+    return append(view_type(copy, piece.size()));
+  }
+
+  basic_string_builder &operator<< (view_type piece) { return append(piece); }
+
+  /// @brief Characters over all pieces.
+  size_type size   (void) const noexcept { return _size; }
+  size_type pieces (void) const noexcept { return _pieces.size() - _first; }
+  bool      empty  (void) const noexcept { return _size == 0; }
+
+  const_iterator begin (void) const noexcept { return _pieces.begin() + _first; }
+  const_iterator end   (void) const noexcept { return _pieces.end(); }
+
+  /// @brief Copies all pieces to @p out, which has room for size().
+  CharT *copy (CharT *out) const {
+    for (const view_type &piece : *this) {
+      Traits::copy(out, piece.data(), piece.size());
+      out += piece.size();
+    }
+    return out;
+  }
+
+  /// @brief The concatenated pieces in a string of type @p String, e.g.
+  ///        std::basic_string or str::basic_string, sized up front.
+  template <class String = std::basic_string<CharT, Traits>>
+  String str (void) const {
+    String out;
+    out.reserve(_size);
+    for (const view_type &piece : *this) { out.append(piece.data(), piece.size()); }
+    return out;
+  }
+
+  /// @brief Drops the first @p n characters, e.g. after a partial write.
+  void consume (size_type n) {
+    n = std::min(n, _size);
+    _size -= n;
+    while (n != 0) {
+      view_type &piece = _pieces[_first];
+      if (n < piece.size()) {
+        piece = view_type(piece.data() + n, piece.size() - n);
+        break;
+      }
+      n -= piece.size();
+      ++_first;
+    }
+    if (_first == _pieces.size()) { clear_pieces(); }
+  }
+
+  /// @brief Forgets the pieces; copies stay in the storage until it is
+  ///        cleared, own blocks are rewound for reuse.
+  void clear (void) {
+    clear_pieces();
+    if (_own) { _own->clear(); }
+  }
+
+#ifdef OMTL_HAVE_WRITEV
+  /// @brief Fills up to @p max iovecs with the pieces from @p first on.
+  ///        @return How many were filled.
+  size_type to_iovec (iovec *out, size_type max, size_type first = 0) const noexcept {
+    const size_type n = std::min(max, pieces() - std::min(first, pieces()));
+    for (size_type i = 0; i < n; ++i) {
+      const view_type &piece = _pieces[_first + first + i];
+      out[i].iov_base = const_cast<CharT *>(piece.data());
+      out[i].iov_len  = piece.size() * sizeof(CharT);
+    }
+    return n;
+  }
+
+  std::vector<iovec> iovecs (void) const {
+    std::vector<iovec> out(pieces());
+    to_iovec(out.data(), out.size());
+    return out;
+  }
+#endif
+
+private:
+  storage_type &copies (void) {
+    if (_copies) { return *_copies; }
+    if (!_own) {
+      _own = owner<storage_type>::make(default_block, typename storage_type::settings_flags(storage_type::settings::alloc_enable));
+    }
+    return *_own;
+  }
+
+  void clear_pieces (void) noexcept {
+    _pieces.clear();
+    _first = 0;
+    _size  = 0;
+  }
+
+  std::vector<view_type> _pieces;
+  size_type              _first  = 0;  ///< Pieces before it were consumed.
+  size_type              _size   = 0;
+  storage_type          *_copies = nullptr;  ///< Storage passed in, if any.
+  owner<storage_type>    _own;
+};
+
+
+using string_builder    = basic_string_builder<char>;
+using wstring_builder   = basic_string_builder<wchar_t>;
+using u16string_builder = basic_string_builder<char16_t>;
+using u32string_builder = basic_string_builder<char32_t>;
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_BUILDER_H
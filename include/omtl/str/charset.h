@@ -0,0 +1,210 @@
+#pragma once
+
+#ifndef OMTL_STR_CHARSET_H
+#define OMTL_STR_CHARSET_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+
+
+namespace omtl {
+namespace str {
+namespace detail {
+
+
+#ifdef OMTL_SIMD_X86
+
+/// Membership test for a block of bytes against nibble tables: the low
+/// nibble selects a row byte, the high nibble selects a bit in that row.
+/// Rows for bytes >= 0x80 live in a second table picked by the sign bit.
+#define OMTL_IMPL_CHARSET_SIMD(_Name, _Isa, _Vec, _Width, _Set1, _Load, _Bcast, _And, _AndNot,  \
+                               _Or, _Srli, _Shuffle, _Cmpeq, _Cmpgt, _Zero, _Mask)             \
+OMTL_TARGET(_Isa)                                                                              \
+inline uint32_t _Name##_match (_Vec block, _Vec lo_tbl, _Vec hi_tbl) noexcept {                \
+  const _Vec nib     = _Set1(0x0F);                                                            \
+  const _Vec bit_lut = _Bcast(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,                      \
+                                            1, 2, 4, 8, 16, 32, 64, -128));                    \
+  const _Vec lo      = _And(block, nib);                                                       \
+  const _Vec hi      = _And(_Srli(block, 4), nib);                                             \
+  const _Vec upper   = _Cmpgt(_Zero(), block);                                                 \
+  const _Vec row     = _Or(_And(upper, _Shuffle(hi_tbl, lo)), _AndNot(upper, _Shuffle(lo_tbl, lo))); \
+  const _Vec bit     = _Shuffle(bit_lut, hi);                                                  \
+  return static_cast<uint32_t>(_Mask(_Cmpeq(_And(row, bit), bit)));                            \
+}                                                                                              \
+                                                                                               \
+OMTL_TARGET(_Isa)                                                                              \
+inline size_t _Name##_find (const char *s, size_t n, const uint8_t *lo, const uint8_t *hi,     \
+                            bool negate, size_t &done) noexcept {                              \
+  const _Vec lo_tbl = _Bcast(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lo)));          \
+  const _Vec hi_tbl = _Bcast(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hi)));          \
+  const uint32_t flip = negate ? static_cast<uint32_t>((uint64_t(1) << _Width) - 1) : 0u;      \
+  size_t i = 0;                                                                                \
+  for (; i + _Width <= n; i += _Width) {                                                       \
+    const _Vec block = _Load(reinterpret_cast<const _Vec *>(s + i));                           \
+    const uint32_t mask = _Name##_match(block, lo_tbl, hi_tbl) ^ flip;                         \
+    if (mask) { return i + bits::ctz(mask); }                                                  \
+  }                                                                                            \
+  done = i;                                                                                    \
+  return size_t(-1);                                                                           \
+}                                                                                              \
+                                                                                               \
+OMTL_TARGET(_Isa)                                                                              \
+inline size_t _Name##_rfind (const char *s, size_t n, const uint8_t *lo, const uint8_t *hi,    \
+                             bool negate, size_t &rest) noexcept {                             \
+  const _Vec lo_tbl = _Bcast(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lo)));          \
+  const _Vec hi_tbl = _Bcast(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hi)));          \
+  const uint32_t flip = negate ? static_cast<uint32_t>((uint64_t(1) << _Width) - 1) : 0u;      \
+  while (n >= _Width) {                                                                        \
+    n -= _Width;                                                                               \
+    const _Vec block = _Load(reinterpret_cast<const _Vec *>(s + n));                           \
+    const uint32_t mask = _Name##_match(block, lo_tbl, hi_tbl) ^ flip;                         \
+    if (mask) { rest = 0; return n + bits::msb(mask); }                                        \
+  }                                                                                            \
+  rest = n;                                                                                    \
+  return size_t(-1);                                                                           \
+}
+
+#define OMTL_BCAST128(_X) (_X)
+#define OMTL_BCAST256(_X) _mm256_broadcastsi128_si256(_X)
+
+OMTL_IMPL_CHARSET_SIMD(charset_ssse3, "ssse3", __m128i, 16, _mm_set1_epi8, _mm_loadu_si128,
+                       OMTL_BCAST128, _mm_and_si128, _mm_andnot_si128, _mm_or_si128,
+                       _mm_srli_epi16, _mm_shuffle_epi8, _mm_cmpeq_epi8, _mm_cmpgt_epi8,
+                       _mm_setzero_si128, _mm_movemask_epi8)
+OMTL_IMPL_CHARSET_SIMD(charset_avx2, "avx2", __m256i, 32, _mm256_set1_epi8, _mm256_loadu_si256,
+                       OMTL_BCAST256, _mm256_and_si256, _mm256_andnot_si256, _mm256_or_si256,
+                       _mm256_srli_epi16, _mm256_shuffle_epi8, _mm256_cmpeq_epi8, _mm256_cmpgt_epi8,
+                       _mm256_setzero_si256, _mm256_movemask_epi8)
+
+#undef OMTL_BCAST256
+#undef OMTL_BCAST128
+#undef OMTL_IMPL_CHARSET_SIMD
+
+#endif  // OMTL_SIMD_X86
+
+}  // namespace detail
+
+
+/// @class Precomputed set of characters for the find_*_of family.
+///        Membership of the first 256 code units is a bitmap lookup; for
+///        single-byte characters the set also keeps nibble tables so that
+///        scans run 16 or 32 bytes per step with SSSE3 / AVX2.
+///        Wider characters outside the bitmap are kept in a small list.
+template <class CharT, class Traits = std::char_traits<CharT>>
+class basic_charset {
+public:
+  using traits_type = Traits;
+  using value_type  = CharT;
+  using size_type   = size_t;
+
+  static constexpr size_type npos = size_type(-1);
+
+  basic_charset (void) noexcept = default;
+
+  basic_charset (const CharT *chars, size_type n) { insert(chars, n); }
+  basic_charset (const CharT *chars) { insert(chars, Traits::length(chars)); }
+
+  void insert (CharT c) {
+    if (!plain_traits) {
+      for (unsigned v = 0; v < 256; ++v) {
+        if (Traits::eq(static_cast<CharT>(v), c)) { set_code(v); }
+      }
+    } else if (code(c) < 256) {
+      set_code(static_cast<unsigned>(code(c)));
+    }
+    if (code(c) >= 256) {
+      _wide.push_back(c);
+    }
+  }
+
+  void insert (const CharT *chars, size_type n) {
+    for (size_type i = 0; i < n; ++i) { insert(chars[i]); }
+  }
+
+  bool contains (CharT c) const noexcept {
+    if (code(c) < 256) {
+      const unsigned v = static_cast<unsigned>(code(c));
+      return (_bits[v >> 6] >> (v & 63)) & 1u;
+    }
+    return !_wide.empty() && Traits::find(_wide.data(), _wide.size(), c) != nullptr;
+  }
+
+  /// @brief Offset of the first character of [s, s + n) that is in the set, or npos.
+  size_type find_first_of     (const CharT *s, size_type n) const noexcept { return scan_forward(s, n, false); }
+  /// @brief Offset of the first character of [s, s + n) that is not in the set, or npos.
+  size_type find_first_not_of (const CharT *s, size_type n) const noexcept { return scan_forward(s, n, true);  }
+  /// @brief Offset of the last character of [s, s + n) that is in the set, or npos.
+  size_type find_last_of      (const CharT *s, size_type n) const noexcept { return scan_backward(s, n, false); }
+  /// @brief Offset of the last character of [s, s + n) that is not in the set, or npos.
+  size_type find_last_not_of  (const CharT *s, size_type n) const noexcept { return scan_backward(s, n, true);  }
+
+private:
+  using code_type = typename std::make_unsigned<CharT>::type;
+
+  static constexpr bool plain_traits = std::is_same<Traits, std::char_traits<CharT>>::value;
+  static constexpr bool byte_chars   = sizeof(CharT) == 1;
+
+  static code_type code (CharT c) noexcept { return static_cast<code_type>(c); }
+
+  void set_code (unsigned v) noexcept {
+    _bits[v >> 6] |= uint64_t(1) << (v & 63);
+    if (v < 128) { _lo_rows[v & 15] |= static_cast<uint8_t>(1u << (v >> 4)); }
+    else         { _hi_rows[v & 15] |= static_cast<uint8_t>(1u << ((v >> 4) - 8)); }
+  }
+
+  size_type scan_forward (const CharT *s, size_type n, bool negate) const noexcept {
+    size_type i = 0;
+#ifdef OMTL_SIMD_X86
+    if (byte_chars && cpu::supports(cpu::feature::ssse3)) {
+      const char *bytes = reinterpret_cast<const char *>(s);
+      const size_type found = cpu::supports(cpu::feature::avx2)
+        ? detail::charset_avx2_find (bytes, n, _lo_rows, _hi_rows, negate, i)
+        : detail::charset_ssse3_find(bytes, n, _lo_rows, _hi_rows, negate, i);
+      if (found != npos) { return found; }
+    }
+#endif
+    for (; i < n; ++i) {
+      if (contains(s[i]) != negate) { return i; }
+    }
+    return npos;
+  }
+
+  size_type scan_backward (const CharT *s, size_type n, bool negate) const noexcept {
+#ifdef OMTL_SIMD_X86
+    if (byte_chars && cpu::supports(cpu::feature::ssse3)) {
+      const char *bytes = reinterpret_cast<const char *>(s);
+      size_type rest;
+      const size_type found = cpu::supports(cpu::feature::avx2)
+        ? detail::charset_avx2_rfind (bytes, n, _lo_rows, _hi_rows, negate, rest)
+        : detail::charset_ssse3_rfind(bytes, n, _lo_rows, _hi_rows, negate, rest);
+      if (found != npos) { return found; }
+      n = rest;
+    }
+#endif
+    for (size_type i = n; i-- > 0;) {
+      if (contains(s[i]) != negate) { return i; }
+    }
+    return npos;
+  }
+
+  uint64_t                  _bits[4]     = { };
+  uint8_t                   _lo_rows[16] = { };
+  uint8_t                   _hi_rows[16] = { };
+  std::basic_string<CharT>  _wide;
+};
+
+
+using charset  = basic_charset<char>;
+using wcharset = basic_charset<wchar_t>;
+
+
+}  // namespace str
+}  // namespace omtl
+
+#endif  // OMTL_STR_CHARSET_H
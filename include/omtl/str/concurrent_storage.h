@@ -0,0 +1,122 @@
+#pragma once
+
+#ifndef OMTL_STR_CONCURRENT_STORAGE_H
+#define OMTL_STR_CONCURRENT_STORAGE_H
+
+
+#include <cstdint>
+#include <mutex>
+
+#include <omtl/memory.h>
+#include <omtl/str/hash.h>
+#include <omtl/str/storage.h>
+
+
+namespace omtl {
+namespace str {
+
+
+/// @class Interning string pool shared between threads.
+///        The hash picks one of @p Shards independent storages, each with
+///        its own index, arena and lock, so threads only contend when they
+///        intern strings landing in the same shard. Returned views point
+///        into arena blocks that never move, so they stay valid while other
+///        threads keep inserting, until clear().
+template <class CharT = char, class Traits = std::char_traits<CharT>, size_t Shards = 64>
+class concurrent_storage {
+public:
+  using string_type  = basic_view<CharT, Traits>;
+  using storage_type = storage<CharT, Traits>;
+
+  static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "Shards must be a power of two");
+
+  explicit concurrent_storage (size_t block_size = 4096, size_t max_block = storage_type::default_max_block);
+
+  concurrent_storage (const concurrent_storage &) = delete;
+  concurrent_storage &operator= (const concurrent_storage &) = delete;
+
+  string_type add  (not_null<string_type> str);
+  string_type find (string_type str) const;
+
+  /// @brief Forgets every string. Not safe against concurrent add()/find().
+  void clear (void);
+
+  size_t capacity (void) const;
+
+private:
+  struct alignas(64) shard_t {
+    shard_t (size_t block_size, size_t max_block)
+      : pool(block_size,
+             typename storage_type::settings_flags(storage_type::settings::intern) | storage_type::settings::alloc_enable,
+             max_block) { }
+
+    mutable std::mutex lock;
+    storage_type       pool;
+  };
+
+  static uint64_t hash_of (string_type str) noexcept { return omtl::str::hash_of(str); }
+
+  static size_t shard_of (uint64_t h) noexcept { return static_cast<size_t>(h >> 32) & (Shards - 1); }
+
+  std::vector<owner<shard_t>> _shards;
+};
+
+
+template <class CharT, class Traits, size_t Shards>
+concurrent_storage<CharT, Traits, Shards>::concurrent_storage (size_t block_size, size_t max_block) {
+  _shards.reserve(Shards);
+  for (size_t i = 0; i < Shards; ++i) {
+    _shards.emplace_back(new shard_t(block_size, max_block));
+  }
+}
+
+
+template <class CharT, class Traits, size_t Shards>
+typename concurrent_storage<CharT, Traits, Shards>::string_type
+concurrent_storage<CharT, Traits, Shards>::add (not_null<string_type> str) {
+  const string_type s = str.get();
+  const uint64_t h = hash_of(s);
+  shard_t &shard = *_shards[shard_of(h)];
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+  uint32_t id;
+  return shard.pool.insert(s, static_cast<uint32_t>(h), false, id);
+}
+
+
+template <class CharT, class Traits, size_t Shards>
+typename concurrent_storage<CharT, Traits, Shards>::string_type
+concurrent_storage<CharT, Traits, Shards>::find (string_type str) const {
+  const uint64_t h = hash_of(str);
+  const shard_t &shard = *_shards[shard_of(h)];
+
+  std::lock_guard<std::mutex> guard(shard.lock);
+  const uint32_t id = shard.pool.lookup(str, static_cast<uint32_t>(h));
+  return id ? shard.pool.resolve(shard.pool._entries[id - 1]) : string_type();
+}
+
+
+template <class CharT, class Traits, size_t Shards>
+void concurrent_storage<CharT, Traits, Shards>::clear (void) {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> guard(shard->lock);
+    shard->pool.clear();
+  }
+}
+
+
+template <class CharT, class Traits, size_t Shards>
+size_t concurrent_storage<CharT, Traits, Shards>::capacity (void) const {
+  size_t total = 0;
+  for (const auto &shard : _shards) {
+    std::lock_guard<std::mutex> guard(shard->lock);
+    total += shard->pool.capacity();
+  }
+  return total;
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+#endif  // OMTL_STR_CONCURRENT_STORAGE_H
@@ -0,0 +1,369 @@
+#pragma once
+
+#ifndef OMTL_STR_HASH_H
+#define OMTL_STR_HASH_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <omtl/utils/cpu.h>
+#include <omtl/str/icase.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+namespace detail {
+
+
+/// wyhash-style mixing: one 64x64->128 multiply folds two words at a time.
+inline uint64_t mix (uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+  const uint64_t lo_lo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+  const uint64_t hi_lo = (a >> 32)         * (b & 0xFFFFFFFFu);
+  const uint64_t lo_hi = (a & 0xFFFFFFFFu) * (b >> 32);
+  const uint64_t hi_hi = (a >> 32)         * (b >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+  const uint64_t hi    = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  const uint64_t lo    = (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+  return lo ^ hi;
+#endif
+}
+
+inline uint64_t read8 (const uint8_t *p) noexcept { uint64_t v; std::memcpy(&v, p, 8); return v; }
+inline uint64_t read4 (const uint8_t *p) noexcept { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+constexpr uint64_t hash_secret[4] = {
+  0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+
+/// Inputs longer than this go through hash_long(): eight independent
+/// accumulators over 64-byte stripes, which SIMD updates two or four at a
+/// time. Below it the three-lane loop of hash_bytes() is faster.
+constexpr size_t long_hash_threshold = 256;
+
+constexpr size_t stripe_bytes      = 64;
+constexpr size_t stripes_per_round = 16;
+
+/// Key words for the stripe accumulators, splitmix64 of the secrets. Each
+/// stripe of a round reads eight of them starting one word further in.
+struct long_hash_key {
+  uint64_t words[8 + stripes_per_round];
+
+  constexpr long_hash_key (void) noexcept : words() {
+    uint64_t x = hash_secret[0];
+    for (uint64_t &w : words) {
+      x += 0x9E3779B97F4A7C15ull;
+      uint64_t z = x;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      w = z ^ (z >> 31);
+    }
+  }
+};
+
+constexpr long_hash_key long_key{};
+constexpr uint64_t      scramble_prime = 0x9E3779B1u;
+
+
+/// acc[i] += data[i ^ 1] + lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i])
+inline void accumulate_scalar (uint64_t *acc, const uint8_t *p, const uint64_t *key) noexcept {
+  for (size_t i = 0; i < 8; ++i) {
+    const uint64_t d  = read8(p + 8 * i);
+    const uint64_t dk = d ^ key[i];
+    acc[i ^ 1] += d;
+    acc[i]     += (dk & 0xFFFFFFFFu) * (dk >> 32);
+  }
+}
+
+inline void scramble_scalar (uint64_t *acc, const uint64_t *key) noexcept {
+  for (size_t i = 0; i < 8; ++i) {
+    acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ key[i]) * scramble_prime;
+  }
+}
+
+
+#ifdef OMTL_SIMD_X86
+
+/// Same arithmetic as the scalar pair, so every path hashes alike: the
+/// swap of adjacent 64-bit lanes gives data[i ^ 1], and the 32x32->64
+/// multiply of a lane by itself shifted gives lo32 * hi32.
+#define OMTL_IMPL_HASH_SIMD(_Name, _Isa, _Vec, _Lanes, _Load, _Store, _Xor, _Add, _Mul, _Srli, _Slli, _Swap, _Set1) \
+OMTL_TARGET(_Isa)                                                                                              \
+inline void _Name##_accumulate (uint64_t *acc, const uint8_t *p, const uint64_t *key, size_t stripes) noexcept { \
+  _Vec a[8 / _Lanes];                                                                                          \
+  for (size_t v = 0; v < 8 / _Lanes; ++v) { a[v] = _Load(reinterpret_cast<const _Vec *>(acc + v * _Lanes)); }  \
+  for (size_t s = 0; s < stripes; ++s, p += stripe_bytes) {                                                    \
+    for (size_t v = 0; v < 8 / _Lanes; ++v) {                                                                  \
+      const _Vec d  = _Load(reinterpret_cast<const _Vec *>(p + 8 * v * _Lanes));                               \
+      const _Vec dk = _Xor(d, _Load(reinterpret_cast<const _Vec *>(key + s + v * _Lanes)));                    \
+      a[v] = _Add(a[v], _Add(_Swap(d), _Mul(dk, _Srli(dk, 32))));                                              \
+    }                                                                                                          \
+  }                                                                                                            \
+  for (size_t v = 0; v < 8 / _Lanes; ++v) { _Store(reinterpret_cast<_Vec *>(acc + v * _Lanes), a[v]); }       \
+}                                                                                                              \
+                                                                                                               \
+OMTL_TARGET(_Isa)                                                                                              \
+inline void _Name##_scramble (uint64_t *acc, const uint64_t *key) noexcept {                                   \
+  const _Vec prime = _Set1(static_cast<int>(scramble_prime));                                                  \
+  for (size_t v = 0; v < 8 / _Lanes; ++v) {                                                                    \
+    _Vec a = _Load(reinterpret_cast<const _Vec *>(acc + v * _Lanes));                                          \
+    a = _Xor(_Xor(a, _Srli(a, 47)), _Load(reinterpret_cast<const _Vec *>(key + v * _Lanes)));                  \
+    a = _Add(_Mul(a, prime), _Slli(_Mul(_Srli(a, 32), prime), 32));                                           \
+    _Store(reinterpret_cast<_Vec *>(acc + v * _Lanes), a);                                                     \
+  }                                                                                                            \
+}
+
+#define OMTL_SWAP64_SSE2(_V) _mm_shuffle_epi32(_V, _MM_SHUFFLE(1, 0, 3, 2))
+#define OMTL_SWAP64_AVX2(_V) _mm256_shuffle_epi32(_V, _MM_SHUFFLE(1, 0, 3, 2))
+
+OMTL_IMPL_HASH_SIMD(hash_sse2, "sse2", __m128i, 2, _mm_loadu_si128, _mm_storeu_si128, _mm_xor_si128,
+                    _mm_add_epi64, _mm_mul_epu32, _mm_srli_epi64, _mm_slli_epi64, OMTL_SWAP64_SSE2, _mm_set1_epi32)
+OMTL_IMPL_HASH_SIMD(hash_avx2, "avx2", __m256i, 4, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_xor_si256,
+                    _mm256_add_epi64, _mm256_mul_epu32, _mm256_srli_epi64, _mm256_slli_epi64, OMTL_SWAP64_AVX2,
+                    _mm256_set1_epi32)
+
+#undef OMTL_SWAP64_SSE2
+#undef OMTL_SWAP64_AVX2
+#undef OMTL_IMPL_HASH_SIMD
+
+#endif  // OMTL_SIMD_X86
+
+
+inline void accumulate (uint64_t *acc, const uint8_t *p, const uint64_t *key, size_t stripes) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2)) { hash_avx2_accumulate(acc, p, key, stripes); return; }
+  hash_sse2_accumulate(acc, p, key, stripes);
+#else
+  for (size_t s = 0; s < stripes; ++s, p += stripe_bytes) { accumulate_scalar(acc, p, key + s); }
+#endif
+}
+
+inline void scramble (uint64_t *acc, const uint64_t *key) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2)) { hash_avx2_scramble(acc, key); return; }
+  hash_sse2_scramble(acc, key);
+#else
+  scramble_scalar(acc, key);
+#endif
+}
+
+
+/// @brief xxh3-style hash for inputs longer than long_hash_threshold.
+inline uint64_t hash_long (const uint8_t *p, size_t len, uint64_t seed) noexcept {
+  uint64_t acc[8] = { hash_secret[0], hash_secret[1], hash_secret[2], hash_secret[3],
+                      ~hash_secret[0], ~hash_secret[1], ~hash_secret[2], seed };
+  const uint64_t *key    = long_key.words;
+  const size_t    round  = stripe_bytes * stripes_per_round;
+  size_t          i      = 0;
+
+  for (; i + round < len; i += round) {
+    accumulate(acc, p + i, key, stripes_per_round);
+    scramble(acc, key + stripes_per_round);
+  }
+  const size_t stripes = (len - 1 - i) / stripe_bytes;
+  accumulate(acc, p + i, key, stripes);
+  // The last stripe ends at the last byte, overlapping what came before.
+  accumulate(acc, p + len - stripe_bytes, key + 7, 1);
+
+  uint64_t h = len * 0x9E3779B185EBCA87ull ^ seed;
+  for (size_t k = 0; k < 8; k += 2) {
+    h += mix(acc[k] ^ key[k + 1], acc[k + 1] ^ key[k + 2]);
+  }
+  return mix(h ^ hash_secret[2], hash_secret[1]);
+}
+
+
+/// @brief 64-bit hash of a byte range. Not cryptographic; the output is
+///        stable across runs and platforms with the same endianness.
+inline uint64_t hash_bytes (const void *data, size_t len, uint64_t seed = 0) noexcept {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  if (len > long_hash_threshold) { return hash_long(p, len, seed); }
+  seed ^= mix(seed ^ hash_secret[0], hash_secret[1]);
+  uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+      b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = mix(read8(p)      ^ hash_secret[1], read8(p + 8)  ^ seed);
+        see1 = mix(read8(p + 16) ^ hash_secret[2], read8(p + 24) ^ see1);
+        see2 = mix(read8(p + 32) ^ hash_secret[3], read8(p + 40) ^ see2);
+        p += 48; i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mix(read8(p) ^ hash_secret[1], read8(p + 8) ^ seed);
+      i -= 16; p += 16;
+    }
+    a = read8(p + i - 16);
+    b = read8(p + i - 8);
+  }
+  return mix(mix(a ^ hash_secret[1], b ^ seed) ^ hash_secret[0] ^ len, hash_secret[1]);
+}
+
+
+/// @brief hash_bytes() of the ASCII-lowered code units, so that strings
+///        equal under ascii_icase_traits hash alike. Lowered a buffer at a
+///        time; a string fitting one buffer hashes as its lowered copy.
+template <class CharT>
+inline uint64_t hash_folded (const CharT *s, size_t n) noexcept {
+  constexpr size_t chunk = long_hash_threshold / sizeof(CharT);
+  CharT    buf[chunk];
+  uint64_t h = 0;
+  size_t   i = 0;
+  do {
+    const size_t len = n - i < chunk ? n - i : chunk;
+    for (size_t k = 0; k < len; ++k) { buf[k] = ascii_lower(s[i + k]); }
+    h = hash_bytes(buf, len * sizeof(CharT), h);
+    i += len;
+  } while (i < n);
+  return h;
+}
+
+
+}  // namespace detail
+
+
+/// @brief Hash of the characters of @p str; equal for every string type
+///        holding the same characters. Views over ascii_icase_traits hash
+///        the lowered characters, consistent with their ==.
+template <class CharT, class Traits>
+inline uint64_t hash_of (basic_view<CharT, Traits> str) noexcept {
+  if (detail::is_icase_traits<Traits>::value) { return detail::hash_folded(str.data(), str.size()); }
+  return detail::hash_bytes(str.data(), str.size() * sizeof(CharT));
+}
+
+
+/// @class View carrying its hash, computed once on construction, so that
+///        repeated lookups of the same key do not hash it again. Compares
+///        hashes before characters.
+template <class CharT, class Traits = std::char_traits<CharT>>
+class basic_hashed_view {
+public:
+  using view_type = basic_view<CharT, Traits>;
+
+  basic_hashed_view (void) noexcept : _hash(hash_of(view_type())) { }
+  basic_hashed_view (view_type str) noexcept : _view(str), _hash(hash_of(str)) { }
+  /// @brief Pairs @p str with a hash the caller already has.
+  basic_hashed_view (view_type str, uint64_t hash) noexcept : _view(str), _hash(hash) { }
+
+  view_type    view (void) const noexcept { return _view; }
+  uint64_t     hash (void) const noexcept { return _hash; }
+  const CharT *data (void) const noexcept { return _view.data(); }
+  size_t       size (void) const noexcept { return _view.size(); }
+
+  operator view_type (void) const noexcept { return _view; }
+
+  friend bool operator == (const basic_hashed_view &a, const basic_hashed_view &b) noexcept {
+    return a._hash == b._hash && a._view == b._view;
+  }
+  friend bool operator != (const basic_hashed_view &a, const basic_hashed_view &b) noexcept { return !(a == b); }
+
+private:
+  view_type _view;
+  uint64_t  _hash;
+};
+
+using hashed_view    = basic_hashed_view<char>;
+using whashed_view   = basic_hashed_view<wchar_t>;
+using u16hashed_view = basic_hashed_view<char16_t>;
+using u32hashed_view = basic_hashed_view<char32_t>;
+
+
+/// @struct Transparent hasher: views, hashed views, std strings and
+///         C strings of the same characters hash alike, and hashed views
+///         give their cached hash. With heterogeneous lookup (C++20
+///         unordered containers, or any is_transparent-aware map) a map
+///         keyed on std::string is probed with a view directly.
+template <class CharT, class Traits = std::char_traits<CharT>>
+struct basic_hash {
+  using is_transparent = void;
+  using view_type      = basic_view<CharT, Traits>;
+
+  size_t operator() (view_type str) const noexcept { return static_cast<size_t>(hash_of(str)); }
+  size_t operator() (const CharT *str) const noexcept { return (*this)(view_type(str)); }
+  size_t operator() (const basic_hashed_view<CharT, Traits> &str) const noexcept { return static_cast<size_t>(str.hash()); }
+
+  template <class Alloc>
+  size_t operator() (const std::basic_string<CharT, Traits, Alloc> &str) const noexcept {
+    return (*this)(view_type(str.data(), str.size()));
+  }
+};
+
+/// @struct Transparent equality matching basic_hash.
+template <class CharT, class Traits = std::char_traits<CharT>>
+struct basic_equal_to {
+  using is_transparent = void;
+  using view_type      = basic_view<CharT, Traits>;
+
+  template <class A, class B>
+  bool operator() (const A &a, const B &b) const noexcept { return as_view(a) == as_view(b); }
+
+private:
+  static view_type as_view (view_type str) noexcept { return str; }
+  static view_type as_view (const CharT *str) noexcept { return view_type(str); }
+  static view_type as_view (const basic_hashed_view<CharT, Traits> &str) noexcept { return str.view(); }
+
+  template <class Alloc>
+  static view_type as_view (const std::basic_string<CharT, Traits, Alloc> &str) noexcept {
+    return view_type(str.data(), str.size());
+  }
+};
+
+using hash     = basic_hash<char>;
+using equal_to = basic_equal_to<char>;
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+namespace std {
+
+#ifndef OMTL_CXX17_SUPPORT
+template <class CharT, class Traits>
+struct hash<omtl::str::basic_view<CharT, Traits>> {
+  size_t operator() (omtl::str::basic_view<CharT, Traits> str) const noexcept {
+    return static_cast<size_t>(omtl::str::hash_of(str));
+  }
+};
+#else
+/// The standard only hashes std::char_traits views; icase views hash folded.
+template <class CharT>
+struct hash<omtl::str::basic_icase_view<CharT>> {
+  size_t operator() (omtl::str::basic_icase_view<CharT> str) const noexcept {
+    return static_cast<size_t>(omtl::str::hash_of(str));
+  }
+};
+#endif
+
+template <class CharT, class Traits>
+struct hash<omtl::str::basic_hashed_view<CharT, Traits>> {
+  size_t operator() (const omtl::str::basic_hashed_view<CharT, Traits> &str) const noexcept {
+    return static_cast<size_t>(str.hash());
+  }
+};
+
+}  // namespace std
+
+#endif  // OMTL_STR_HASH_H
@@ -0,0 +1,271 @@
+#pragma once
+
+#ifndef OMTL_STR_ICASE_H
+#define OMTL_STR_ICASE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+#include <omtl/str/search.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+namespace detail {
+
+
+/// Only 'A'..'Z' fold; every other code unit, including non-ASCII UTF-8
+/// bytes, compares exactly.
+template <class CharT>
+constexpr CharT ascii_lower (CharT c) noexcept {
+  return (c >= CharT('A') && c <= CharT('Z')) ? CharT(c + (CharT('a') - CharT('A'))) : c;
+}
+
+template <class CharT>
+constexpr auto ascii_lower_unsigned (CharT c) noexcept {
+  return static_cast<std::make_unsigned_t<CharT>>(ascii_lower(c));
+}
+
+/// @brief First offset where [a, a + n) and [b, b + n) differ after
+///        folding, or n.
+template <class CharT>
+constexpr size_t icase_mismatch_scalar (const CharT *a, const CharT *b, size_t n) noexcept {
+  size_t i = 0;
+  while (i < n && ascii_lower(a[i]) == ascii_lower(b[i])) { ++i; }
+  return i;
+}
+
+template <class CharT>
+constexpr const CharT *icase_find_char_scalar (const CharT *s, size_t n, CharT c) noexcept {
+  c = ascii_lower(c);
+  for (size_t i = 0; i < n; ++i) {
+    if (ascii_lower(s[i]) == c) { return s + i; }
+  }
+  return nullptr;
+}
+
+template <class CharT>
+constexpr size_t icase_search_scalar (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  for (size_t i = 0; i + m <= n; ++i) {
+    if (icase_mismatch_scalar(h + i, x, m) == m) { return i; }
+  }
+  return not_found;
+}
+
+
+#ifdef OMTL_SIMD_X86
+
+/// Folding a block: bytes whose distance from 'A' is at most 25 (unsigned,
+/// via min_epu8) are upper case and get 0x20 or'ed in. The search filter is
+/// cheaper still: or'ing 0x20 into every byte maps both cases of a letter
+/// to the lower one, so a candidate only needs or + cmpeq per needle byte;
+/// the few non-letters it confuses ('@' with '`', ...) fail verification.
+#define OMTL_IMPL_ICASE_SIMD(_Name, _Isa, _Vec, _Width, _Set1, _Load, _Cmp, _And, _Or, _Sub, _Min, _Mask, _Full) \
+OMTL_TARGET(_Isa)                                                                                 \
+inline _Vec _Name##_fold (_Vec v) noexcept {                                                      \
+  const _Vec off   = _Sub(v, _Set1('A'));                                                         \
+  const _Vec upper = _Cmp(_Min(off, _Set1(25)), off);                                             \
+  return _Or(v, _And(upper, _Set1(0x20)));                                                        \
+}                                                                                                 \
+                                                                                                  \
+OMTL_TARGET(_Isa)                                                                                 \
+inline size_t _Name##_mismatch (const char *a, const char *b, size_t n) noexcept {                \
+  size_t i = 0;                                                                                   \
+  for (; i + _Width <= n; i += _Width) {                                                          \
+    const _Vec va = _Name##_fold(_Load(reinterpret_cast<const _Vec *>(a + i)));                   \
+    const _Vec vb = _Name##_fold(_Load(reinterpret_cast<const _Vec *>(b + i)));                   \
+    const uint32_t eq = static_cast<uint32_t>(_Mask(_Cmp(va, vb)));                               \
+    if (eq != _Full) { return i + bits::ctz(~eq); }                                               \
+  }                                                                                               \
+  return i + icase_mismatch_scalar(a + i, b + i, n - i);                                          \
+}                                                                                                 \
+                                                                                                  \
+OMTL_TARGET(_Isa)                                                                                 \
+inline const char *_Name##_find_char (const char *s, size_t n, char c) noexcept {                 \
+  const char   lower = ascii_lower(c);                                                            \
+  const _Vec   fold  = _Set1(lower >= 'a' && lower <= 'z' ? 0x20 : 0);                           \
+  const _Vec   want  = _Set1(lower);                                                              \
+  size_t i = 0;                                                                                   \
+  for (; i + _Width <= n; i += _Width) {                                                          \
+    const _Vec block = _Or(_Load(reinterpret_cast<const _Vec *>(s + i)), fold);                   \
+    const uint32_t mask = static_cast<uint32_t>(_Mask(_Cmp(block, want)));                        \
+    if (mask) { return s + i + bits::ctz(mask); }                                                 \
+  }                                                                                               \
+  return icase_find_char_scalar(s + i, n - i, c);                                                 \
+}                                                                                                 \
+                                                                                                  \
+OMTL_TARGET(_Isa)                                                                                 \
+inline size_t _Name##_search (const char *h, size_t n, const char *x, size_t m) noexcept {        \
+  const char f = ascii_lower(x[0]), l = ascii_lower(x[m - 1]);                                    \
+  const _Vec first  = _Set1(f), first_fold = _Set1(f >= 'a' && f <= 'z' ? 0x20 : 0);              \
+  const _Vec last   = _Set1(l), last_fold  = _Set1(l >= 'a' && l <= 'z' ? 0x20 : 0);              \
+  size_t i = 0;                                                                                   \
+  for (; i + m - 1 + _Width <= n; i += _Width) {                                                  \
+    const _Vec bf = _Or(_Load(reinterpret_cast<const _Vec *>(h + i)), first_fold);               \
+    const _Vec bl = _Or(_Load(reinterpret_cast<const _Vec *>(h + i + m - 1)), last_fold);         \
+    uint32_t mask = static_cast<uint32_t>(_Mask(_And(_Cmp(bf, first), _Cmp(bl, last))));         \
+    while (mask) {                                                                                \
+      const unsigned bit = bits::ctz(mask);                                                       \
+      if (_Name##_mismatch(h + i + bit, x, m) == m) { return i + bit; }                           \
+      mask &= mask - 1;                                                                           \
+    }                                                                                             \
+  }                                                                                               \
+  if (i + m > n) { return not_found; }                                                            \
+  const size_t r = icase_search_scalar(h + i, n - i, x, m);                                       \
+  return r == not_found ? not_found : i + r;                                                      \
+}
+
+OMTL_IMPL_ICASE_SIMD(icase_sse2, "sse2", __m128i, 16, _mm_set1_epi8, _mm_loadu_si128, _mm_cmpeq_epi8,
+                     _mm_and_si128, _mm_or_si128, _mm_sub_epi8, _mm_min_epu8, _mm_movemask_epi8, 0xFFFFu)
+OMTL_IMPL_ICASE_SIMD(icase_avx2, "avx2", __m256i, 32, _mm256_set1_epi8, _mm256_loadu_si256, _mm256_cmpeq_epi8,
+                     _mm256_and_si256, _mm256_or_si256, _mm256_sub_epi8, _mm256_min_epu8, _mm256_movemask_epi8, 0xFFFFFFFFu)
+
+#undef OMTL_IMPL_ICASE_SIMD
+
+#endif  // OMTL_SIMD_X86
+
+
+template <class CharT>
+constexpr size_t icase_mismatch (const CharT *a, const CharT *b, size_t n) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (std::is_same<CharT, char>::value && !cpu::constant_evaluated()) {
+    const char *ca = reinterpret_cast<const char *>(a), *cb = reinterpret_cast<const char *>(b);
+    if (cpu::supports(cpu::feature::avx2)) { return icase_avx2_mismatch(ca, cb, n); }
+    return icase_sse2_mismatch(ca, cb, n);
+  }
+#endif
+  return icase_mismatch_scalar(a, b, n);
+}
+
+template <class CharT>
+constexpr const CharT *icase_find_char (const CharT *s, size_t n, CharT c) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (std::is_same<CharT, char>::value && !cpu::constant_evaluated()) {
+    const char *cs = reinterpret_cast<const char *>(s);
+    const char *found = cpu::supports(cpu::feature::avx2) ? icase_avx2_find_char(cs, n, static_cast<char>(c))
+                                                          : icase_sse2_find_char(cs, n, static_cast<char>(c));
+    return found ? s + (found - cs) : nullptr;
+  }
+#endif
+  return icase_find_char_scalar(s, n, c);
+}
+
+template <class CharT>
+constexpr size_t icase_search (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  if (m == 0) { return 0; }
+  if (m > n)  { return not_found; }
+  if (m == 1) {
+    const CharT *p = icase_find_char(h, n, x[0]);
+    return p ? static_cast<size_t>(p - h) : not_found;
+  }
+#ifdef OMTL_SIMD_X86
+  if (std::is_same<CharT, char>::value && !cpu::constant_evaluated()) {
+    const char *ch = reinterpret_cast<const char *>(h), *cx = reinterpret_cast<const char *>(x);
+    if (cpu::supports(cpu::feature::avx2)) { return icase_avx2_search(ch, n, cx, m); }
+    return icase_sse2_search(ch, n, cx, m);
+  }
+#endif
+  return icase_search_scalar(h, n, x, m);
+}
+
+
+}  // namespace detail
+
+
+/// @struct Character traits comparing ASCII letters without regard to case,
+///         e.g. for HTTP header names. Only 'A'..'Z' fold, so the result
+///         does not depend on the locale, and bytes of UTF-8 sequences
+///         compare exactly. For char, compare() and find() run SIMD kernels
+///         that fold 16 or 32 bytes at a time, so a basic_view over these
+///         traits compares and searches without building a lowered copy.
+///         Ordering is by the lowered code units, as unsigned values.
+template <class CharT>
+struct ascii_icase_traits : std::char_traits<CharT> {
+  using char_type = CharT;
+
+  static constexpr bool eq (CharT a, CharT b) noexcept {
+    return detail::ascii_lower(a) == detail::ascii_lower(b);
+  }
+
+  static constexpr bool lt (CharT a, CharT b) noexcept {
+    return detail::ascii_lower_unsigned(a) < detail::ascii_lower_unsigned(b);
+  }
+
+  static constexpr int compare (const CharT *a, const CharT *b, size_t n) noexcept {
+    const size_t i = detail::icase_mismatch(a, b, n);
+    if (i == n) { return 0; }
+    return lt(a[i], b[i]) ? -1 : 1;
+  }
+
+  static constexpr const CharT *find (const CharT *s, size_t n, const CharT &c) noexcept {
+    return detail::icase_find_char(s, n, c);
+  }
+};
+
+
+namespace detail {
+
+/// Whether @p Traits compares ASCII letters without regard to case, so that
+/// hashes over it must fold the code units first.
+template <class Traits>
+struct is_icase_traits : std::false_type { };
+
+template <class CharT>
+struct is_icase_traits<ascii_icase_traits<CharT>> : std::true_type { };
+
+}  // namespace detail
+
+
+template <class CharT>
+using basic_icase_view = basic_view<CharT, ascii_icase_traits<CharT>>;
+
+using icase_view    = basic_icase_view<char>;
+using icase_wview   = basic_icase_view<wchar_t>;
+
+
+/// @brief The same characters viewed through ascii_icase_traits, so that
+///        ==, <, find() and friends ignore case.
+template <class CharT, class Traits>
+constexpr basic_icase_view<CharT> as_icase (basic_view<CharT, Traits> str) noexcept {
+  return basic_icase_view<CharT>(str.data(), str.size());
+}
+
+
+template <class CharT, class Traits>
+constexpr bool equals_icase (basic_view<CharT, Traits> a, basic_view<CharT, Traits> b) noexcept {
+  return a.size() == b.size() && detail::icase_mismatch(a.data(), b.data(), a.size()) == a.size();
+}
+
+template <class CharT, class Traits>
+constexpr bool starts_with_icase (basic_view<CharT, Traits> str, basic_view<CharT, Traits> prefix) noexcept {
+  return prefix.size() <= str.size() && detail::icase_mismatch(str.data(), prefix.data(), prefix.size()) == prefix.size();
+}
+
+template <class CharT, class Traits>
+constexpr bool ends_with_icase (basic_view<CharT, Traits> str, basic_view<CharT, Traits> suffix) noexcept {
+  return suffix.size() <= str.size() &&
+         detail::icase_mismatch(str.data() + str.size() - suffix.size(), suffix.data(), suffix.size()) == suffix.size();
+}
+
+/// @brief Offset of the first case-insensitive occurrence of @p needle at
+///        or after @p pos, or npos. Candidates are filtered on the folded
+///        first and last needle characters a vector at a time.
+template <class CharT, class Traits>
+constexpr size_t find_icase (basic_view<CharT, Traits> str, basic_view<CharT, Traits> needle, size_t pos = 0) noexcept {
+  if (pos > str.size()) { return basic_view<CharT, Traits>::npos; }
+  const size_t found = detail::icase_search(str.data() + pos, str.size() - pos, needle.data(), needle.size());
+  return found == detail::not_found ? basic_view<CharT, Traits>::npos : pos + found;
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_ICASE_H
@@ -0,0 +1,305 @@
+#pragma once
+
+#ifndef OMTL_STR_MAPPED_STORAGE_H
+#define OMTL_STR_MAPPED_STORAGE_H
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define OMTL_HAVE_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <omtl/str/storage.h>
+
+
+namespace omtl {
+namespace str {
+
+
+/// @class Read-only string pool opened from a snapshot written by write().
+///        The file is mapped as is and never copied: blocks, index entries
+///        and hash slots are used in place, so several processes opening
+///        the same snapshot share its pages through the page cache.
+///
+///        Layout (native endianness, every section 8-byte aligned):
+///          header | block table {offset, used} | entries | slots | data
+///        All positions are relative to the start of the file.
+template <class CharT = char, class Traits = std::char_traits<CharT>>
+class mapped_storage {
+public:
+  using string_type  = basic_view<CharT, Traits>;
+  using storage_type = storage<CharT, Traits>;
+
+  mapped_storage (void) = default;
+  ~mapped_storage (void) { close(); }
+
+  mapped_storage (mapped_storage &&cp) noexcept { swap(cp); }
+  mapped_storage &operator= (mapped_storage &&cp) noexcept { swap(cp); return *this; }
+
+  mapped_storage (const mapped_storage &) = delete;
+  mapped_storage &operator= (const mapped_storage &) = delete;
+
+  /// @brief Serializes @p pool. Only interned strings are indexed; the
+  ///        data of every block is kept, so get() works for all of it.
+  static bool write (const storage_type &pool, const char *path);
+
+  bool open  (const char *path);
+  void close (void);
+
+  bool   is_open (void) const noexcept { return _base != nullptr; }
+  size_t size    (void) const noexcept { return is_open() ? static_cast<size_t>(header().entry_count) : 0; }
+
+  /// @brief Characters [offset, offset + sz) of the concatenated blocks.
+  ///        Offsets inside the first block match storage::get().
+  string_type get  (ptrdiff_t offset, size_t sz) const;
+  string_type find (string_type str) const;
+
+  /// @brief Handles issued by the storage before write() stay valid here.
+  string_type   get       (string_handle h) const;
+  string_handle handle_of (string_type str) const;
+
+  void swap (mapped_storage &o) noexcept {
+    std::swap(_base, o._base);
+    std::swap(_size, o._size);
+    std::swap(_copy, o._copy);
+  }
+
+private:
+  using entry_t = typename storage_type::entry_t;
+  using slot_t  = typename storage_type::slot_t;
+
+  struct header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t char_size;
+    uint64_t block_count;
+    uint64_t entry_count;
+    uint64_t slot_count;
+    uint64_t blocks_at;
+    uint64_t entries_at;
+    uint64_t slots_at;
+    uint64_t data_at;
+    uint64_t data_size;
+  };
+
+  struct block_ref_t {
+    uint64_t offset;
+    uint64_t used;
+  };
+
+  static constexpr char     magic[8] = { 'O', 'M', 'T', 'L', 'S', 'T', 'R', '\0' };
+  static constexpr uint32_t version  = 2;  ///< 2: hash_bytes() changed for long strings.
+
+  static uint64_t align8 (uint64_t v) noexcept { return (v + 7) & ~uint64_t(7); }
+
+  template <class T>
+  const T *section (uint64_t at) const noexcept { return reinterpret_cast<const T *>(_base + at); }
+
+  const header_t &header (void) const noexcept { return *section<header_t>(0); }
+  const CharT    *data   (void) const noexcept { return section<CharT>(header().data_at); }
+
+  bool validate (void) const;
+
+  const uint8_t        *_base = nullptr;
+  size_t                _size = 0;
+  std::vector<uint8_t>  _copy;  ///< Backing buffer where mmap is unavailable.
+};
+
+
+template <class CharT, class Traits>
+constexpr char mapped_storage<CharT, Traits>::magic[8];
+
+
+template <class CharT, class Traits>
+bool mapped_storage<CharT, Traits>::write (const storage_type &pool, const char *path) {
+  header_t h;
+  std::memcpy(h.magic, magic, sizeof(magic));
+  h.version     = version;
+  h.char_size   = sizeof(CharT);
+  h.block_count = pool._blocks.size();
+  h.entry_count = pool._entries.size();
+  h.slot_count  = pool._slots.size();
+  h.blocks_at   = align8(sizeof(header_t));
+  h.entries_at  = align8(h.blocks_at  + h.block_count * sizeof(block_ref_t));
+  h.slots_at    = align8(h.entries_at + h.entry_count * sizeof(entry_t));
+  h.data_at     = align8(h.slots_at   + h.slot_count  * sizeof(slot_t));
+
+  std::vector<block_ref_t> blocks;
+  uint64_t offset = 0;
+  for (const auto &block : pool._blocks) {
+    blocks.push_back({ offset, block->used });
+    offset += block->used;
+  }
+  h.data_size = offset;
+
+  std::FILE *file = std::fopen(path, "wb");
+  if (!file) { return false; }
+
+  const uint64_t zero = 0;
+  uint64_t at = 0;
+  auto put = [&] (const void *p, uint64_t bytes, uint64_t where) {
+    bool ok = where < at || std::fwrite(&zero, 1, where - at, file) == where - at;
+    ok = ok && (bytes == 0 || std::fwrite(p, 1, bytes, file) == bytes);
+    at = where + bytes;
+    return ok;
+  };
+
+  bool ok = put(&h, sizeof(h), 0)
+         && put(blocks.data(),        blocks.size()        * sizeof(block_ref_t), h.blocks_at)
+         && put(pool._entries.data(), pool._entries.size() * sizeof(entry_t),     h.entries_at)
+         && put(pool._slots.data(),   pool._slots.size()   * sizeof(slot_t),      h.slots_at);
+  for (size_t b = 0; ok && b < pool._blocks.size(); ++b) {
+    ok = put(pool._blocks[b]->begin(), pool._blocks[b]->used * sizeof(CharT),
+             h.data_at + blocks[b].offset * sizeof(CharT));
+  }
+  return std::fclose(file) == 0 && ok;
+}
+
+
+template <class CharT, class Traits>
+bool mapped_storage<CharT, Traits>::open (const char *path) {
+  close();
+#ifdef OMTL_HAVE_MMAP
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) { return false; }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(header_t))) {
+    ::close(fd);
+    return false;
+  }
+  void *mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) { return false; }
+  _base = static_cast<const uint8_t *>(mapped);
+  _size = static_cast<size_t>(st.st_size);
+#else
+  std::FILE *file = std::fopen(path, "rb");
+  if (!file) { return false; }
+  std::fseek(file, 0, SEEK_END);
+  const long bytes = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  if (bytes < static_cast<long>(sizeof(header_t))) { std::fclose(file); return false; }
+  _copy.resize(static_cast<size_t>(bytes));
+  const bool read = std::fread(_copy.data(), 1, _copy.size(), file) == _copy.size();
+  std::fclose(file);
+  if (!read) { _copy.clear(); return false; }
+  _base = _copy.data();
+  _size = _copy.size();
+#endif
+
+  if (!validate()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+
+template <class CharT, class Traits>
+void mapped_storage<CharT, Traits>::close (void) {
+#ifdef OMTL_HAVE_MMAP
+  if (_base) { ::munmap(const_cast<uint8_t *>(_base), _size); }
+#endif
+  _copy.clear();
+  _base = nullptr;
+  _size = 0;
+}
+
+
+template <class CharT, class Traits>
+bool mapped_storage<CharT, Traits>::validate (void) const {
+  const header_t &h = header();
+  if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != version || h.char_size != sizeof(CharT)) {
+    return false;
+  }
+  if ((h.slot_count & (h.slot_count - 1)) != 0) { return false; }
+
+  auto fits = [this] (uint64_t at, uint64_t count, uint64_t item) {
+    return at <= _size && count <= (_size - at) / item;
+  };
+  if (!fits(h.blocks_at,  h.block_count, sizeof(block_ref_t)) ||
+      !fits(h.entries_at, h.entry_count, sizeof(entry_t))     ||
+      !fits(h.slots_at,   h.slot_count,  sizeof(slot_t))      ||
+      !fits(h.data_at,    h.data_size,   sizeof(CharT))) {
+    return false;
+  }
+
+  const block_ref_t *blocks = section<block_ref_t>(h.blocks_at);
+  for (uint64_t b = 0; b < h.block_count; ++b) {
+    if (blocks[b].offset > h.data_size || blocks[b].used > h.data_size - blocks[b].offset) { return false; }
+  }
+  const entry_t *entries = section<entry_t>(h.entries_at);
+  for (uint64_t e = 0; e < h.entry_count; ++e) {
+    if (entries[e].block >= h.block_count ||
+        uint64_t(entries[e].offset) + entries[e].length > blocks[entries[e].block].used) {
+      return false;
+    }
+  }
+  const slot_t *slots = section<slot_t>(h.slots_at);
+  uint64_t used = 0;
+  for (uint64_t i = 0; i < h.slot_count; ++i) {
+    used += slots[i].entry != 0;
+  }
+  return used < h.slot_count || h.slot_count == 0;
+}
+
+
+template <class CharT, class Traits>
+typename mapped_storage<CharT, Traits>::string_type
+mapped_storage<CharT, Traits>::get (ptrdiff_t offset, size_t sz) const {
+  assert(is_open() && uint64_t(offset) + sz <= header().data_size);
+  return string_type(data() + offset, sz);
+}
+
+
+template <class CharT, class Traits>
+typename mapped_storage<CharT, Traits>::string_type
+mapped_storage<CharT, Traits>::find (string_type str) const {
+  const string_handle h = handle_of(str);
+  return h ? get(h) : string_type();
+}
+
+
+template <class CharT, class Traits>
+typename mapped_storage<CharT, Traits>::string_type
+mapped_storage<CharT, Traits>::get (string_handle h) const {
+  assert(is_open() && h && h.id() <= header().entry_count);
+  const entry_t &e = section<entry_t>(header().entries_at)[h.id() - 1];
+  return string_type(data() + section<block_ref_t>(header().blocks_at)[e.block].offset + e.offset, e.length);
+}
+
+
+template <class CharT, class Traits>
+string_handle mapped_storage<CharT, Traits>::handle_of (string_type str) const {
+  if (!is_open() || header().slot_count == 0) { return string_handle(); }
+
+  const uint32_t     h       = storage_type::hash_of(str);
+  const block_ref_t *blocks  = section<block_ref_t>(header().blocks_at);
+  const entry_t     *entries = section<entry_t>(header().entries_at);
+  const slot_t      *slots   = section<slot_t>(header().slots_at);
+  const size_t       mask    = static_cast<size_t>(header().slot_count) - 1;
+
+  for (size_t i = h & mask; slots[i].entry != 0; i = (i + 1) & mask) {
+    if (slots[i].hash != h || slots[i].entry > header().entry_count) { continue; }
+    const entry_t &e = entries[slots[i].entry - 1];
+    if (e.length == str.length()) {
+      const CharT *candidate = data() + blocks[e.block].offset + e.offset;
+      if (Traits::compare(candidate, str.data(), str.length()) == 0) { return string_handle(slots[i].entry); }
+    }
+  }
+  return string_handle();
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+#endif  // OMTL_STR_MAPPED_STORAGE_H
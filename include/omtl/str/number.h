@@ -0,0 +1,498 @@
+#pragma once
+
+#ifndef OMTL_STR_NUMBER_H
+#define OMTL_STR_NUMBER_H
+
+
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#  include <charconv>
+#endif
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+
+
+/// @struct Outcome of parse(), with the error codes of std::from_chars:
+///         invalid_argument when no number starts the text, length 0;
+///         result_out_of_range when the number does not fit @p T, with
+///         length covering it. The value is T() on either error.
+template <class T>
+struct parse_result {
+  T         value  = T();
+  size_t    length = 0;  ///< Characters consumed.
+  std::errc ec     = std::errc::invalid_argument;
+
+  constexpr explicit operator bool (void) const noexcept { return ec == std::errc(); }
+};
+
+
+namespace detail {
+
+
+template <class T>
+using if_integer = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>;
+
+template <class T>
+using if_float = std::enable_if_t<std::is_same<T, float>::value || std::is_same<T, double>::value, int>;
+
+
+template <class CharT>
+constexpr bool is_digit (CharT c) noexcept { return c >= CharT('0') && c <= CharT('9'); }
+
+/// Value of @p c as a digit of bases up to 36, or 36 for a non-digit.
+template <class CharT>
+constexpr unsigned digit_value (CharT c) noexcept {
+  if (c >= CharT('0') && c <= CharT('9')) { return static_cast<unsigned>(c - CharT('0')); }
+  if (c >= CharT('a') && c <= CharT('z')) { return static_cast<unsigned>(c - CharT('a')) + 10; }
+  if (c >= CharT('A') && c <= CharT('Z')) { return static_cast<unsigned>(c - CharT('A')) + 10; }
+  return 36;
+}
+
+constexpr uint64_t pow10_u64[20] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+  1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+  100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+  1000000000000000000ull, 10000000000000000000ull
+};
+
+/// Any 19 decimal digits fit 64 bits; the 20th may not.
+constexpr size_t safe_digits = 19;
+
+
+template <class CharT>
+constexpr const CharT *parse_based (const CharT *p, const CharT *e, unsigned base, uint64_t &value, bool &overflow) noexcept {
+  const uint64_t limit = std::numeric_limits<uint64_t>::max() / base;
+  for (; p < e; ++p) {
+    const unsigned d = digit_value(*p);
+    if (d >= base) { break; }
+    if (value > limit || value * base > std::numeric_limits<uint64_t>::max() - d) { overflow = true; }
+    value = value * base + d;
+  }
+  return p;
+}
+
+
+/// SWAR digit runs, after Lemire: a word holds eight digits when every
+/// byte has high nibble 3 and stays there after adding 6. They are then
+/// combined in three multiplications, pairs, quads and the whole.
+inline uint64_t load_word (const char *s) noexcept {
+  uint64_t w;
+  std::memcpy(&w, s, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  w = __builtin_bswap64(w);
+#endif
+  return w;
+}
+
+inline bool is_eight_digits (uint64_t w) noexcept {
+  return ((w & 0xF0F0F0F0F0F0F0F0ull) | (((w + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+inline uint32_t eight_digits (uint64_t w) noexcept {
+  w -= 0x3030303030303030ull;
+  w  = (w * 10) + (w >> 8);
+  w  = (((w & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+        (((w >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+  return static_cast<uint32_t>(w);
+}
+
+
+#ifdef OMTL_SIMD_X86
+
+/// pshufb masks moving the first n of 16 bytes to the end, zeroing the
+/// rest: the mask for n starts at byte n.
+alignas(16) constexpr uint8_t digit_align[32] = {
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+/// Converts the run of up to 16 digits at @p s, which must have 16
+/// readable bytes. The digits are right-aligned so that leading zero
+/// lanes drop out, then multiply-added in pairs, quads and eighths.
+struct digit_run {
+  uint64_t value;
+  unsigned length;
+};
+
+OMTL_TARGET("ssse3")
+inline digit_run digits16_ssse3 (const char *s) noexcept {
+  const __m128i  d    = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s)), _mm_set1_epi8('0'));
+  const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d)));
+  const unsigned n    = bits::ctz(~mask);
+  const __m128i aligned = _mm_shuffle_epi8(d, _mm_loadu_si128(reinterpret_cast<const __m128i *>(digit_align + n)));
+  const __m128i pairs   = _mm_maddubs_epi16(aligned, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+  const __m128i quads   = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+  const __m128i eighths = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_setr_epi16(10000, 1, 10000, 1, 0, 0, 0, 0));
+  const uint64_t value  = uint64_t(static_cast<uint32_t>(_mm_cvtsi128_si32(eighths))) * 100000000ull +
+                          static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(eighths, 4)));
+  return { value, n };
+}
+
+#endif  // OMTL_SIMD_X86
+
+
+/// Accumulates the digits at @p s, at least 9 characters from @p e, 16 or
+/// 8 at a time, and returns where the kernels stopped.
+inline const char *long_digit_run (const char *s, const char *e, uint64_t &value) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (e - s >= 16 && cpu::supports(cpu::feature::ssse3)) {
+    const digit_run run = digits16_ssse3(s);
+    value = run.value;
+    return s + run.length;
+  }
+#endif
+  for (; e - s >= 8 && is_eight_digits(load_word(s)); s += 8) { value = value * 100000000ull + eight_digits(load_word(s)); }
+  return s;
+}
+
+/// Exact value of the run [first, last) of more than 19 digits: without
+/// leading zeros, 19 digits or fewer are what wrapping accumulation gave,
+/// 20 are redone with a checked last step, and more overflow.
+template <class CharT>
+constexpr uint64_t wide_decimal (const CharT *first, const CharT *last, uint64_t value, bool &overflow) noexcept {
+  while (first < last && *first == CharT('0')) { ++first; }
+  const size_t n = static_cast<size_t>(last - first);
+  if (n > safe_digits + 1) {
+    overflow = true;
+  } else if (n == safe_digits + 1) {
+    value = 0;
+    for (; first < last - 1; ++first) { value = value * 10 + static_cast<unsigned>(*first - CharT('0')); }
+    const unsigned d = static_cast<unsigned>(*first - CharT('0'));
+    overflow = value > (std::numeric_limits<uint64_t>::max() - d) / 10;
+    value    = value * 10 + d;
+  }
+  return value;
+}
+
+/// Base-10 magnitude at @p p; returns the end of the digit run. Runs
+/// reaching 9 characters take the 16- or 8-digit kernels, while the
+/// common short field stays on a plain loop small enough to inline. The
+/// value may wrap as it accumulates, so runs past 19 characters get a
+/// second look.
+template <class CharT>
+constexpr const CharT *parse_decimal (const CharT *p, const CharT *e, uint64_t &value, bool &overflow) noexcept {
+  const CharT *first = p;
+  uint64_t     v     = 0;
+  if (std::is_same<CharT, char>::value && !cpu::constant_evaluated() && e - p > 8 && is_digit(p[8])) {
+    p += long_digit_run(reinterpret_cast<const char *>(p), reinterpret_cast<const char *>(e), v) - reinterpret_cast<const char *>(p);
+  }
+  for (; p < e && is_digit(*p); ++p) { v = v * 10 + static_cast<unsigned>(*p - CharT('0')); }
+  if (static_cast<size_t>(p - first) > safe_digits) { v = wide_decimal(first, p, v, overflow); }
+  value = v;
+  return p;
+}
+
+
+/// Number of decimal digits of @p v: a guess from the bit length, less
+/// one below the power of ten it names.
+constexpr unsigned decimal_length (uint64_t v) noexcept {
+  v |= 1;
+  const unsigned guess = ((bits::msb64(v) + 1) * 1233) >> 12;
+  return guess + (v >= pow10_u64[guess]);
+}
+
+constexpr char digit_pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+/// Writes @p v as exactly @p n digits ending at @p out + @p n, two at a
+/// time from the back.
+template <class CharT>
+constexpr void write_decimal (uint64_t v, unsigned n, CharT *out) noexcept {
+  CharT *p = out + n;
+  while (v >= 100) {
+    const unsigned i = static_cast<unsigned>(v % 100) * 2;
+    v /= 100;
+    *--p = static_cast<CharT>(digit_pairs[i + 1]);
+    *--p = static_cast<CharT>(digit_pairs[i]);
+  }
+  if (v >= 10) {
+    *--p = static_cast<CharT>(digit_pairs[v * 2 + 1]);
+    *--p = static_cast<CharT>(digit_pairs[v * 2]);
+  } else {
+    *--p = static_cast<CharT>('0' + v);
+  }
+}
+
+
+/// Clinger's fast path: a decimal of at most 19 significant digits whose
+/// mantissa is exact in @p T, scaled by a power of ten that is exact too,
+/// rounds correctly with one multiplication or division. That covers the
+/// prices, timings and ratios of typical data; the rest goes to the
+/// standard library.
+template <class T>
+struct float_bounds;
+
+template <>
+struct float_bounds<double> {
+  static constexpr uint64_t max_mantissa = 1ull << 53;
+  static constexpr int      max_exponent = 22;
+};
+
+template <>
+struct float_bounds<float> {
+  static constexpr uint64_t max_mantissa = 1ull << 24;
+  static constexpr int      max_exponent = 10;
+};
+
+constexpr double pow10_f64[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Parses the general-format number at @p s on the fast path and returns
+/// its end, or nullptr when the text needs the slow path: no digits
+/// (which includes inf and nan), more than 19 significant digits, or a
+/// mantissa or exponent out of bounds.
+template <class T>
+inline const char *parse_float_fast (const char *s, const char *e, T &value) noexcept {
+  const char *p   = s;
+  const bool  neg = p < e && *p == '-';
+  p += neg;
+
+  uint64_t mantissa  = 0;
+  unsigned digits    = 0;  // Significant ones, from the first non-zero.
+  int      exponent  = 0;
+  bool     any       = false;
+  bool     truncated = false;
+  for (; p < e && is_digit(*p); ++p) {
+    any = true;
+    if (digits < safe_digits) {
+      mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+      digits  += mantissa != 0;
+    } else {
+      ++exponent;
+      truncated |= *p != '0';
+    }
+  }
+  if (p < e && *p == '.') {
+    const char *frac = ++p;
+    for (; p < e && is_digit(*p); ++p) {
+      if (digits < safe_digits) {
+        mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+        digits  += mantissa != 0;
+        --exponent;
+      } else {
+        truncated |= *p != '0';
+      }
+    }
+    any |= p != frac;
+  }
+  if (!any || truncated) { return nullptr; }
+
+  if (p < e && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    const bool  negative_exponent = q < e && *q == '-';
+    q += q < e && (*q == '-' || *q == '+');
+    if (q < e && is_digit(*q)) {
+      int x = 0;
+      for (; q < e && is_digit(*q); ++q) {
+        if (x < 100000) { x = x * 10 + (*q - '0'); }
+      }
+      exponent += negative_exponent ? -x : x;
+      p = q;
+    }
+  }
+
+  if (mantissa == 0) {
+    value = neg ? -T(0) : T(0);
+    return p;
+  }
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+  return nullptr;  // Wider intermediates, as on x87, would round twice.
+#endif
+  if (mantissa > float_bounds<T>::max_mantissa ||
+      exponent < -float_bounds<T>::max_exponent || exponent > float_bounds<T>::max_exponent) { return nullptr; }
+
+  T v = static_cast<T>(mantissa);
+  v   = exponent < 0 ? v / static_cast<T>(pow10_f64[-exponent]) : v * static_cast<T>(pow10_f64[exponent]);
+  value = neg ? -v : v;
+  return p;
+}
+
+/// The slow path: std::from_chars where the library has it for floating
+/// point, else strtod on a terminated copy, after rejecting the leading
+/// space, '+' and hexadecimal forms that strtod alone would accept.
+template <class T>
+inline parse_result<T> parse_float_slow (const char *s, const char *e) {
+  parse_result<T> r;
+#if defined(__cpp_lib_to_chars)
+  T value;
+  const std::from_chars_result fc = std::from_chars(s, e, value, std::chars_format::general);
+  if (fc.ec == std::errc::invalid_argument) { return r; }
+  r.length = static_cast<size_t>(fc.ptr - s);
+  r.ec     = fc.ec;
+  if (fc.ec == std::errc()) { r.value = value; }
+  return r;
+#else
+  const char *p = s + (s < e && *s == '-');
+  if (p == e || !(is_digit(*p) || *p == '.' || digit_value(*p) < 36) || (p + 1 < e && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))) {
+    return r;
+  }
+  char        local[128];
+  std::string heap;
+  const size_t n = static_cast<size_t>(e - s);
+  char *copy = local;
+  if (n >= sizeof(local)) { heap.assign(s, n); copy = &heap[0]; }
+  else                    { std::memcpy(local, s, n); local[n] = '\0'; }
+
+  char *end = nullptr;
+  errno = 0;
+  const T value = std::is_same<T, float>::value ? static_cast<T>(std::strtof(copy, &end)) : static_cast<T>(std::strtod(copy, &end));
+  if (end == copy) { return r; }
+  r.length = static_cast<size_t>(end - copy);
+  // ERANGE also flags subnormal results, which from_chars accepts.
+  r.ec     = errno == ERANGE && (value == 0 || std::isinf(value)) ? std::errc::result_out_of_range : std::errc();
+  if (r.ec == std::errc()) { r.value = value; }
+  return r;
+#endif
+}
+
+
+template <class T, bool = std::is_integral<T>::value>
+struct max_format_size_of : std::integral_constant<size_t, std::numeric_limits<T>::digits10 + 1 + std::is_signed<T>::value> { };
+
+/// Shortest round-trip forms, e.g. "-2.2250738585072014e-308".
+template <class T>
+struct max_format_size_of<T, false> : std::integral_constant<size_t, std::is_same<T, float>::value ? 15 : 24> { };
+
+
+}  // namespace detail
+
+
+/// @brief Characters that format() writes at most for a @p T.
+template <class T>
+constexpr size_t max_format_size = detail::max_format_size_of<T>::value;
+
+
+/// @brief Parses the integer at the start of @p str, with std::from_chars
+///        rules: an optional '-' for signed types, then digits of @p base,
+///        2 to 36, without prefix. No leading space, '+' or locale, and no
+///        copy: the view need not be terminated. In base 10, runs of 9
+///        characters or more, such as ids and timestamps, convert 16
+///        digits per step with SSSE3, else 8 with SWAR.
+template <class T, class CharT, class Traits, detail::if_integer<T> = 0>
+constexpr parse_result<T> parse_prefix (basic_view<CharT, Traits> str, int base = 10) noexcept {
+  using U = std::make_unsigned_t<T>;
+  parse_result<T> r;
+  const CharT *s = str.data(), *e = s + str.size();
+  const CharT *p = s;
+  const bool   neg = std::is_signed<T>::value && p < e && *p == CharT('-');
+  p += neg;
+
+  uint64_t     magnitude = 0;
+  bool         overflow  = false;
+  const CharT *end = base == 10 ? detail::parse_decimal(p, e, magnitude, overflow)
+                                : detail::parse_based(p, e, static_cast<unsigned>(base), magnitude, overflow);
+  if (end == p) { return r; }
+
+  r.length = static_cast<size_t>(end - s);
+  const uint64_t limit = uint64_t(std::numeric_limits<T>::max()) + neg;
+  if (overflow || magnitude > limit) {
+    r.ec = std::errc::result_out_of_range;
+    return r;
+  }
+  r.value = static_cast<T>(neg ? U(0 - magnitude) : U(magnitude));
+  r.ec    = std::errc();
+  return r;
+}
+
+/// @brief Parses the floating-point number at the start of @p str, in the
+///        general format of std::from_chars: an optional '-', digits with
+///        an optional point, an optional exponent; inf and nan as well.
+///        Most data takes an exact fast path; longer or extreme values are
+///        handed to std::from_chars, or strtod on a copy where the library
+///        lacks it, which then follows the C locale's decimal point.
+template <class T, class Traits, detail::if_float<T> = 0>
+inline parse_result<T> parse_prefix (basic_view<char, Traits> str) {
+  const char *s = str.data(), *e = s + str.size();
+  parse_result<T> r;
+  if (const char *end = detail::parse_float_fast(s, e, r.value)) {
+    r.length = static_cast<size_t>(end - s);
+    r.ec     = std::errc();
+    return r;
+  }
+  return detail::parse_float_slow<T>(s, e);
+}
+
+/// @brief Parses @p str as a whole: trailing characters make it
+///        invalid_argument, e.g. for fields that split() and trim() left.
+template <class T, class CharT, class Traits, detail::if_integer<T> = 0>
+constexpr parse_result<T> parse (basic_view<CharT, Traits> str, int base = 10) noexcept {
+  parse_result<T> r = parse_prefix<T>(str, base);
+  if (r.length != str.size()) { r = parse_result<T>(); }
+  return r;
+}
+
+template <class T, class Traits, detail::if_float<T> = 0>
+inline parse_result<T> parse (basic_view<char, Traits> str) {
+  parse_result<T> r = parse_prefix<T>(str);
+  if (r.length != str.size()) { r = parse_result<T>(); }
+  return r;
+}
+
+/// @brief Value of @p str as a whole, or @p fallback.
+template <class T, class CharT, class Traits>
+inline T parse_or (basic_view<CharT, Traits> str, T fallback) {
+  const parse_result<T> r = parse<T>(str);
+  return r ? r.value : fallback;
+}
+
+
+/// @brief Writes @p value in base 10 to @p out, which must have room for
+///        max_format_size<T> characters, and returns the count written.
+///        Nothing is terminated. The length is known up front from the
+///        bit length, so digits go straight to their place, two per
+///        division.
+template <class T, class CharT, detail::if_integer<T> = 0>
+constexpr size_t format (T value, CharT *out) noexcept {
+  using U = std::make_unsigned_t<T>;
+  const bool     neg       = std::is_signed<T>::value && value < T(0);
+  const uint64_t magnitude = neg ? 0 - uint64_t(int64_t(value)) : uint64_t(U(value));
+  if (neg) { *out++ = CharT('-'); }
+  const unsigned n = detail::decimal_length(magnitude);
+  detail::write_decimal(magnitude, n, out);
+  return n + neg;
+}
+
+/// @brief Writes the shortest form of @p value that parses back to it,
+///        in the manner of std::to_chars. Where the library lacks
+///        floating-point to_chars, "%.17g" (or "%.9g") stands in: exact,
+///        not always shortest, and in the C locale's format.
+template <class T, detail::if_float<T> = 0>
+inline size_t format (T value, char *out) {
+#if defined(__cpp_lib_to_chars)
+  return static_cast<size_t>(std::to_chars(out, out + max_format_size<T>, value).ptr - out);
+#else
+  char buf[32];
+  const int n = std::snprintf(buf, sizeof(buf), std::is_same<T, float>::value ? "%.9g" : "%.17g", static_cast<double>(value));
+  std::memcpy(out, buf, static_cast<size_t>(n));
+  return static_cast<size_t>(n);
+#endif
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_NUMBER_H
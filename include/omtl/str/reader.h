@@ -0,0 +1,417 @@
+#pragma once
+
+#ifndef OMTL_STR_READER_H
+#define OMTL_STR_READER_H
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define OMTL_HAVE_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+#include <omtl/utils/flags.h>
+#include <omtl/str/search.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+
+
+enum class read_opt {
+  strip_cr,    ///< Drop a '\r' before the delimiter, for CRLF input.
+  skip_empty,  ///< Do not yield empty records.
+
+  __SENTINEL__
+};
+
+using read_flags = omtl::flags<read_opt>;
+
+
+namespace detail {
+
+
+#ifdef OMTL_SIMD_X86
+
+/// Positions of @p c among the 64 bytes at @p s, one bit each.
+#define OMTL_IMPL_DELIM_MASK(_Name, _Isa, _Vec, _Width, _Set1, _Load, _Cmp, _Mask) \
+OMTL_TARGET(_Isa)                                                                  \
+inline uint64_t _Name (const char *s, char c) noexcept {                           \
+  const _Vec needle = _Set1(c);                                                    \
+  uint64_t mask = 0;                                                               \
+  for (unsigned i = 0; i < 64; i += _Width) {                                      \
+    const _Vec block = _Load(reinterpret_cast<const _Vec *>(s + i));               \
+    mask |= uint64_t(static_cast<uint32_t>(_Mask(_Cmp(block, needle)))) << i;      \
+  }                                                                                \
+  return mask;                                                                     \
+}
+
+OMTL_IMPL_DELIM_MASK(delim_mask_sse2, "sse2", __m128i, 16, _mm_set1_epi8, _mm_loadu_si128,
+                     _mm_cmpeq_epi8, _mm_movemask_epi8)
+OMTL_IMPL_DELIM_MASK(delim_mask_avx2, "avx2", __m256i, 32, _mm256_set1_epi8, _mm256_loadu_si256,
+                     _mm256_cmpeq_epi8, _mm256_movemask_epi8)
+
+#undef OMTL_IMPL_DELIM_MASK
+
+#endif  // OMTL_SIMD_X86
+
+
+/// @class Finds successive delimiters. For bytes, 64 are compared per
+///        step and the resulting bitmask is kept, so the records that end
+///        in the same 64 bytes cost one ctz each instead of a memchr call.
+///        Other characters go through Traits::find.
+template <class CharT, class Traits>
+class delimiter_scanner {
+public:
+  explicit delimiter_scanner (CharT delim) noexcept : _delim(delim) { }
+
+  CharT delimiter (void) const noexcept { return _delim; }
+
+  /// @brief Forgets the cached mask, e.g. after the buffer moved.
+  void reset (void) noexcept { _chunk = nullptr; _mask = 0; }
+
+  const CharT *find (const CharT *p, const CharT *end) noexcept {
+    return find(is_bytewise<CharT, Traits>(), p, end);
+  }
+
+private:
+  const CharT *find (std::false_type, const CharT *p, const CharT *end) noexcept {
+    const CharT *found = Traits::find(p, static_cast<size_t>(end - p), _delim);
+    return found ? found : end;
+  }
+
+  const CharT *find (std::true_type, const CharT *p, const CharT *end) noexcept {
+#ifdef OMTL_SIMD_X86
+    if (_chunk && p >= _chunk && p < _chunk + 64) {
+      const uint64_t left = _mask & (~uint64_t(0) << (p - _chunk));
+      if (left) { return _chunk + bits::ctz64(left); }
+      p = _chunk + 64;
+    }
+    const bool avx2 = cpu::supports(cpu::feature::avx2);
+    while (end - p >= 64) {
+      _chunk = p;
+      _mask  = avx2 ? delim_mask_avx2(p, _delim) : delim_mask_sse2(p, _delim);
+      if (_mask) { return p + bits::ctz64(_mask); }
+      p += 64;
+    }
+#endif
+    return find(std::false_type(), p, end);
+  }
+
+  CharT        _delim;
+  const CharT *_chunk = nullptr;  ///< Start of the 64 bytes _mask covers.
+  uint64_t     _mask  = 0;
+};
+
+
+}  // namespace detail
+
+
+/// @class Reads delimited records, lines by default, as views straight
+///        into its input, so split(), trim() and parsing run on the data
+///        with no per-record copy.
+///
+///        A regular file is mapped whole and the views stay valid until
+///        close(). Pipes, sockets, std::FILE and std::istream input is read
+///        into one reusable buffer: when a record crosses its end, the
+///        partial record moves to the front before the next read, and the
+///        buffer doubles only for a record longer than itself. Those views
+///        are valid until the next call to next().
+///
+///        A final record without a trailing delimiter is yielded as well.
+template <class CharT = char, class Traits = std::char_traits<CharT>>
+class basic_line_reader {
+public:
+  using view_type = basic_view<CharT, Traits>;
+  using size_type = size_t;
+
+  static constexpr size_type default_buffer = 64 * 1024;
+
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = view_type;
+    using difference_type   = ptrdiff_t;
+    using pointer           = const view_type *;
+    using reference         = const view_type &;
+
+    iterator (void) noexcept = default;
+
+    reference operator *  (void) const noexcept { return  _record; }
+    pointer   operator -> (void) const noexcept { return &_record; }
+
+    iterator &operator ++ (void) { advance(); return *this; }
+
+    bool operator == (const iterator &o) const noexcept { return _reader == o._reader; }
+    bool operator != (const iterator &o) const noexcept { return _reader != o._reader; }
+
+  private:
+    friend class basic_line_reader;
+
+    explicit iterator (basic_line_reader *reader) : _reader(reader) { advance(); }
+
+    void advance (void) {
+      if (!_reader->next(_record)) { _reader = nullptr; }
+    }
+
+    basic_line_reader *_reader = nullptr;
+    view_type          _record;
+  };
+
+  explicit basic_line_reader (CharT delim = CharT('\n'), read_flags flags = read_flags(),
+                              size_type buffer = default_buffer)
+    : _scanner(delim), _flags(flags), _buffer_size(std::max<size_type>(buffer, 64)) { }
+
+  ~basic_line_reader (void) { close(); }
+
+  basic_line_reader (const basic_line_reader &) = delete;
+  basic_line_reader &operator= (const basic_line_reader &) = delete;
+
+  /// @brief Maps @p path if it is a regular file, or reads it through the
+  ///        buffer otherwise, e.g. for a FIFO or /dev/stdin.
+  bool open (const char *path);
+  /// @brief Reads from @p file, which is not closed by the reader.
+  bool open (std::FILE *file);
+  bool open (std::istream &in);
+  /// @brief Splits text already in memory, which must outlive the reader.
+  void open (view_type text);
+
+  void close (void);
+
+  /// @brief Next record, without its delimiter. @return false at the end
+  ///        of the input or on a read error, see failed().
+  bool next (view_type &record);
+
+  iterator begin (void) { return iterator(this); }
+  iterator end   (void) noexcept { return iterator(); }
+
+  bool      is_open   (void) const noexcept { return _source != source::none; }
+  bool      is_mapped (void) const noexcept { return _mapped != nullptr; }
+  bool      failed    (void) const noexcept { return _failed; }
+  /// @brief Records returned so far, i.e. the current line number.
+  size_type records   (void) const noexcept { return _records; }
+
+private:
+  enum class source { none, memory, fd, file, stream };
+
+  bool open_stream (source from);
+  bool fill (void);
+  size_t read_bytes (char *out, size_t n);
+
+  detail::delimiter_scanner<CharT, Traits> _scanner;
+  read_flags  _flags;
+  source      _source = source::none;
+
+  const CharT *_pos = nullptr;  ///< Unread input, [_pos, _end).
+  const CharT *_end = nullptr;
+  bool         _eof    = false;
+  bool         _failed = false;
+  size_type    _records = 0;
+
+  void        *_mapped     = nullptr;
+  size_t       _mapped_len = 0;
+
+  int           _fd     = -1;
+  std::FILE    *_file   = nullptr;
+  bool          _own_file = false;
+  std::istream *_stream = nullptr;
+
+  size_type          _buffer_size;
+  std::vector<CharT> _buffer;
+  size_t             _partial = 0;  ///< Bytes of an incomplete unit after _end.
+};
+
+
+using line_reader  = basic_line_reader<char>;
+using wline_reader = basic_line_reader<wchar_t>;
+
+
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::open (const char *path) {
+  close();
+#ifdef OMTL_HAVE_MMAP
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) { return false; }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+  if (!S_ISREG(st.st_mode)) {
+    _fd = fd;
+    return open_stream(source::fd);
+  }
+  const size_t bytes = static_cast<size_t>(st.st_size);
+  if (bytes >= sizeof(CharT)) {
+    void *mapped = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) { ::close(fd); return false; }
+#  ifdef MADV_SEQUENTIAL
+    ::madvise(mapped, bytes, MADV_SEQUENTIAL);
+#  endif
+    _mapped     = mapped;
+    _mapped_len = bytes;
+  }
+  ::close(fd);
+  _source = source::memory;
+  _pos = static_cast<const CharT *>(_mapped);
+  _end = _pos + bytes / sizeof(CharT);
+  _eof = true;
+  return true;
+#else
+  std::FILE *file = std::fopen(path, "rb");
+  if (!file) { return false; }
+  _file     = file;
+  _own_file = true;
+  return open_stream(source::file);
+#endif
+}
+
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::open (std::FILE *file) {
+  close();
+  if (!file) { return false; }
+  _file = file;
+  return open_stream(source::file);
+}
+
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::open (std::istream &in) {
+  close();
+  _stream = &in;
+  return open_stream(source::stream);
+}
+
+template <class CharT, class Traits>
+void basic_line_reader<CharT, Traits>::open (view_type text) {
+  close();
+  _source = source::memory;
+  _pos = text.data();
+  _end = text.data() + text.size();
+  _eof = true;
+}
+
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::open_stream (source from) {
+  _source = from;
+  _buffer.resize(_buffer_size);
+  _pos = _end = _buffer.data();
+  return true;
+}
+
+template <class CharT, class Traits>
+void basic_line_reader<CharT, Traits>::close (void) {
+#ifdef OMTL_HAVE_MMAP
+  if (_mapped) { ::munmap(_mapped, _mapped_len); }
+  if (_fd >= 0) { ::close(_fd); }
+#endif
+  if (_file && _own_file) { std::fclose(_file); }
+  _mapped = nullptr;
+  _mapped_len = 0;
+  _fd = -1;
+  _file = nullptr;
+  _own_file = false;
+  _stream = nullptr;
+  _source = source::none;
+  _pos = _end = nullptr;
+  _eof = _failed = false;
+  _records = 0;
+  _partial = 0;
+  _scanner.reset();
+}
+
+
+template <class CharT, class Traits>
+size_t basic_line_reader<CharT, Traits>::read_bytes (char *out, size_t n) {
+  switch (_source) {
+#ifdef OMTL_HAVE_MMAP
+  case source::fd: {
+    for (;;) {
+      const ssize_t got = ::read(_fd, out, n);
+      if (got >= 0) { return static_cast<size_t>(got); }
+      if (errno != EINTR) { _failed = true; return 0; }
+    }
+  }
+#endif
+  case source::file: {
+    const size_t got = std::fread(out, 1, n, _file);
+    if (got == 0 && std::ferror(_file)) { _failed = true; }
+    return got;
+  }
+  case source::stream: {
+    _stream->read(out, static_cast<std::streamsize>(n));
+    if (_stream->bad()) { _failed = true; }
+    return static_cast<size_t>(_stream->gcount());
+  }
+  default:
+    return 0;
+  }
+}
+
+/// Moves the unread input to the front, growing the buffer if it is all
+/// one record, and reads more after it. @return false at the end.
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::fill (void) {
+  if (_eof) { return false; }
+  CharT *const base = _buffer.data();
+  const size_t unread = static_cast<size_t>(_end - _pos);
+  if (_pos != base) {
+    std::memmove(base, _pos, unread * sizeof(CharT) + _partial);
+  } else if (unread == _buffer.size()) {
+    _buffer.resize(2 * _buffer.size());
+  }
+  CharT *const data = _buffer.data();
+  _scanner.reset();
+
+  char *const  into = reinterpret_cast<char *>(data + unread) + _partial;
+  const size_t room = (_buffer.size() - unread) * sizeof(CharT) - _partial;
+  const size_t got  = read_bytes(into, room);
+  if (got == 0) { _eof = true; }
+  _partial += got;
+  _pos = data;
+  _end = data + unread + _partial / sizeof(CharT);
+  _partial %= sizeof(CharT);
+  return got != 0;
+}
+
+
+template <class CharT, class Traits>
+bool basic_line_reader<CharT, Traits>::next (view_type &record) {
+  for (;;) {
+    const CharT *delim = _scanner.find(_pos, _end);
+    while (delim == _end) {
+      const size_t scanned = static_cast<size_t>(_end - _pos);
+      if (!fill()) { delim = _end; break; }
+      delim = _scanner.find(_pos + scanned, _end);
+    }
+    if (_pos == _end && delim == _end) { return false; }
+
+    const CharT *start = _pos;
+    size_t       len   = static_cast<size_t>(delim - start);
+    _pos = delim == _end ? _end : delim + 1;
+
+    if (_flags.test(read_opt::strip_cr) && len != 0 && Traits::eq(start[len - 1], CharT('\r'))) { --len; }
+    if (len == 0 && _flags.test(read_opt::skip_empty)) { continue; }
+    record = view_type(start, len);
+    ++_records;
+    return true;
+  }
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_READER_H
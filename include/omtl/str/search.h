@@ -0,0 +1,323 @@
+#pragma once
+
+#ifndef OMTL_STR_SEARCH_H
+#define OMTL_STR_SEARCH_H
+
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+
+
+namespace omtl {
+namespace str {
+namespace detail {
+
+
+constexpr size_t not_found = size_t(-1);
+
+/// Needles longer than this are searched with Two-Way, which stays linear
+/// in the haystack length; shorter ones use the first/last byte filter.
+constexpr size_t two_way_threshold = 32;
+
+
+/// @struct True when Traits compares characters as raw bytes, i.e. when
+///         the SIMD and memchr/memcmp paths produce the same answers.
+template <class CharT, class Traits>
+struct is_bytewise : std::false_type { };
+
+template <>
+struct is_bytewise<char, std::char_traits<char>> : std::true_type { };
+
+
+template <class CharT>
+struct forward_seq {
+  const CharT *first;
+  const CharT &operator[] (ptrdiff_t i) const { return first[i]; }
+};
+
+template <class CharT>
+struct reverse_seq {
+  const CharT *last;
+  const CharT &operator[] (ptrdiff_t i) const { return last[-i]; }
+};
+
+
+template <class Traits, class Seq>
+ptrdiff_t maximal_suffix (Seq x, ptrdiff_t m, bool inverted, ptrdiff_t &period) {
+  ptrdiff_t ms = -1, j = 0, k = 1, p = 1;
+  while (j + k < m) {
+    const auto a = x[j + k];
+    const auto b = x[ms + k];
+    if (Traits::eq(a, b)) {
+      if (k != p) { ++k; } else { j += p; k = 1; }
+    } else if (inverted ? Traits::lt(b, a) : Traits::lt(a, b)) {
+      j += k; k = 1; p = j - ms;
+    } else {
+      ms = j; j = ms + 1; k = p = 1;
+    }
+  }
+  period = p;
+  return ms;
+}
+
+/// @brief Crochemore-Perrin Two-Way matching, O(n + m) time, O(1) space.
+///        Requires 0 < m <= n. Sequences are accessed through [] so the
+///        same code serves reverse search over reverse_seq.
+template <class Traits, class Seq>
+size_t two_way (Seq y, ptrdiff_t n, Seq x, ptrdiff_t m) {
+  ptrdiff_t p1, p2;
+  const ptrdiff_t i1 = maximal_suffix<Traits>(x, m, false, p1);
+  const ptrdiff_t i2 = maximal_suffix<Traits>(x, m, true,  p2);
+  const ptrdiff_t ell = i1 > i2 ? i1 : i2;
+  ptrdiff_t per       = i1 > i2 ? p1 : p2;
+
+  bool periodic = true;
+  for (ptrdiff_t i = 0; i <= ell && periodic; ++i) {
+    periodic = Traits::eq(x[i], x[i + per]);
+  }
+
+  ptrdiff_t j = 0;
+  if (periodic) {
+    ptrdiff_t memory = -1;
+    while (j <= n - m) {
+      ptrdiff_t i = (ell > memory ? ell : memory) + 1;
+      while (i < m && Traits::eq(x[i], y[i + j])) { ++i; }
+      if (i >= m) {
+        i = ell;
+        while (i > memory && Traits::eq(x[i], y[i + j])) { --i; }
+        if (i <= memory) { return static_cast<size_t>(j); }
+        j += per;
+        memory = m - per - 1;
+      } else {
+        j += i - ell;
+        memory = -1;
+      }
+    }
+  } else {
+    per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+    while (j <= n - m) {
+      ptrdiff_t i = ell + 1;
+      while (i < m && Traits::eq(x[i], y[i + j])) { ++i; }
+      if (i >= m) {
+        i = ell;
+        while (i >= 0 && Traits::eq(x[i], y[i + j])) { --i; }
+        if (i < 0) { return static_cast<size_t>(j); }
+        j += per;
+      } else {
+        j += i - ell;
+      }
+    }
+  }
+  return not_found;
+}
+
+
+template <class CharT, class Traits>
+constexpr size_t search_scalar (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  const CharT *cur  = h;
+  const CharT *stop = h + (n - m) + 1;
+  while (cur < stop) {
+    cur = Traits::find(cur, static_cast<size_t>(stop - cur), x[0]);
+    if (!cur) { return not_found; }
+    if (Traits::compare(cur + 1, x + 1, m - 1) == 0) { return static_cast<size_t>(cur - h); }
+    ++cur;
+  }
+  return not_found;
+}
+
+template <class CharT, class Traits>
+constexpr size_t rsearch_scalar (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  for (size_t i = n - m + 1; i-- > 0;) {
+    if (Traits::eq(h[i], x[0]) && Traits::compare(h + i + 1, x + 1, m - 1) == 0) {
+      return i;
+    }
+  }
+  return not_found;
+}
+
+template <class CharT, class Traits>
+constexpr size_t rfind_char_scalar (const CharT *h, size_t n, CharT c) noexcept {
+  for (size_t i = n; i-- > 0;) {
+    if (Traits::eq(h[i], c)) { return i; }
+  }
+  return not_found;
+}
+
+
+#ifdef OMTL_SIMD_X86
+
+/// First/last byte filtering: a candidate offset must match both the first
+/// and the last needle byte, which rejects almost every position with two
+/// compares per lane. Survivors are verified with memcmp. Requires m >= 2.
+#define OMTL_IMPL_SEARCH_SIMD(_Name, _Isa, _Vec, _Width, _Set1, _Load, _Cmp, _And, _Mask) \
+OMTL_TARGET(_Isa)                                                                          \
+inline size_t _Name (const char *h, size_t n, const char *x, size_t m) noexcept {          \
+  const _Vec first = _Set1(x[0]);                                                          \
+  const _Vec last  = _Set1(x[m - 1]);                                                      \
+  size_t i = 0;                                                                            \
+  for (; i + m - 1 + _Width <= n; i += _Width) {                                           \
+    const _Vec bf = _Load(reinterpret_cast<const _Vec *>(h + i));                          \
+    const _Vec bl = _Load(reinterpret_cast<const _Vec *>(h + i + m - 1));                  \
+    uint32_t mask = static_cast<uint32_t>(_Mask(_And(_Cmp(bf, first), _Cmp(bl, last))));   \
+    while (mask) {                                                                         \
+      const unsigned bit = bits::ctz(mask);                                                \
+      if (std::memcmp(h + i + bit + 1, x + 1, m - 2) == 0) { return i + bit; }             \
+      mask &= mask - 1;                                                                    \
+    }                                                                                      \
+  }                                                                                        \
+  if (i + m > n) { return not_found; }                                                     \
+  const size_t r = search_scalar<char, std::char_traits<char>>(h + i, n - i, x, m);        \
+  return r == not_found ? not_found : i + r;                                               \
+}                                                                                          \
+                                                                                           \
+OMTL_TARGET(_Isa)                                                                          \
+inline size_t r##_Name (const char *h, size_t n, const char *x, size_t m) noexcept {       \
+  const _Vec first = _Set1(x[0]);                                                          \
+  const _Vec last  = _Set1(x[m - 1]);                                                      \
+  size_t end = n - m + 1;                                                                  \
+  while (end >= _Width) {                                                                  \
+    const size_t i = end - _Width;                                                         \
+    const _Vec bf = _Load(reinterpret_cast<const _Vec *>(h + i));                          \
+    const _Vec bl = _Load(reinterpret_cast<const _Vec *>(h + i + m - 1));                  \
+    uint32_t mask = static_cast<uint32_t>(_Mask(_And(_Cmp(bf, first), _Cmp(bl, last))));   \
+    while (mask) {                                                                         \
+      const unsigned bit = bits::msb(mask);                                                \
+      if (std::memcmp(h + i + bit + 1, x + 1, m - 2) == 0) { return i + bit; }             \
+      mask &= ~(1u << bit);                                                                \
+    }                                                                                      \
+    end = i;                                                                               \
+  }                                                                                        \
+  if (end == 0) { return not_found; }                                                      \
+  return rsearch_scalar<char, std::char_traits<char>>(h, end + m - 1, x, m);               \
+}                                                                                          \
+                                                                                           \
+OMTL_TARGET(_Isa)                                                                          \
+inline size_t _Name##_rchar (const char *h, size_t n, char c) noexcept {                   \
+  const _Vec needle = _Set1(c);                                                            \
+  while (n >= _Width) {                                                                    \
+    n -= _Width;                                                                           \
+    const _Vec block = _Load(reinterpret_cast<const _Vec *>(h + n));                       \
+    const uint32_t mask = static_cast<uint32_t>(_Mask(_Cmp(block, needle)));               \
+    if (mask) { return n + bits::msb(mask); }                                              \
+  }                                                                                        \
+  return rfind_char_scalar<char, std::char_traits<char>>(h, n, c);                         \
+}
+
+OMTL_IMPL_SEARCH_SIMD(search_sse2, "sse2", __m128i, 16, _mm_set1_epi8, _mm_loadu_si128,
+                      _mm_cmpeq_epi8, _mm_and_si128, _mm_movemask_epi8)
+OMTL_IMPL_SEARCH_SIMD(search_avx2, "avx2", __m256i, 32, _mm256_set1_epi8, _mm256_loadu_si256,
+                      _mm256_cmpeq_epi8, _mm256_and_si256, _mm256_movemask_epi8)
+
+#undef OMTL_IMPL_SEARCH_SIMD
+
+#endif  // OMTL_SIMD_X86
+
+
+inline size_t search_short (const char *h, size_t n, const char *x, size_t m) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2)) { return search_avx2(h, n, x, m); }
+  return search_sse2(h, n, x, m);
+#else
+  return search_scalar<char, std::char_traits<char>>(h, n, x, m);
+#endif
+}
+
+inline size_t rsearch_short (const char *h, size_t n, const char *x, size_t m) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2)) { return rsearch_avx2(h, n, x, m); }
+  return rsearch_sse2(h, n, x, m);
+#else
+  return rsearch_scalar<char, std::char_traits<char>>(h, n, x, m);
+#endif
+}
+
+
+template <class CharT, class Traits>
+size_t search_short (std::false_type, const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  return search_scalar<CharT, Traits>(h, n, x, m);
+}
+
+template <class CharT, class Traits>
+size_t search_short (std::true_type, const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  return search_short(h, n, x, m);
+}
+
+template <class CharT, class Traits>
+size_t rsearch_short (std::false_type, const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  return rsearch_scalar<CharT, Traits>(h, n, x, m);
+}
+
+template <class CharT, class Traits>
+size_t rsearch_short (std::true_type, const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  return rsearch_short(h, n, x, m);
+}
+
+template <class CharT, class Traits>
+size_t rfind_char (std::false_type, const CharT *h, size_t n, CharT c) noexcept {
+  return rfind_char_scalar<CharT, Traits>(h, n, c);
+}
+
+template <class CharT, class Traits>
+size_t rfind_char (std::true_type, const CharT *h, size_t n, CharT c) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2)) { return search_avx2_rchar(h, n, c); }
+  return search_sse2_rchar(h, n, c);
+#else
+  return rfind_char_scalar<CharT, Traits>(h, n, c);
+#endif
+}
+
+
+/// @brief Offset of the first occurrence of [x, x + m) in [h, h + n).
+///        Constant evaluation takes the scalar scan.
+template <class CharT, class Traits>
+constexpr size_t search (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  if (m == 0) { return 0; }
+  if (m > n)  { return not_found; }
+  if (cpu::constant_evaluated()) { return search_scalar<CharT, Traits>(h, n, x, m); }
+  if (m == 1) {
+    const CharT *p = Traits::find(h, n, x[0]);
+    return p ? static_cast<size_t>(p - h) : not_found;
+  }
+  if (m > two_way_threshold) {
+    return two_way<Traits>(forward_seq<CharT>{h}, static_cast<ptrdiff_t>(n),
+                           forward_seq<CharT>{x}, static_cast<ptrdiff_t>(m));
+  }
+  return search_short<CharT, Traits>(is_bytewise<CharT, Traits>(), h, n, x, m);
+}
+
+/// @brief Offset of the last occurrence of [x, x + m) in [h, h + n).
+template <class CharT, class Traits>
+constexpr size_t rsearch (const CharT *h, size_t n, const CharT *x, size_t m) noexcept {
+  if (m == 0) { return n; }
+  if (m > n)  { return not_found; }
+  if (cpu::constant_evaluated()) { return rsearch_scalar<CharT, Traits>(h, n, x, m); }
+  if (m == 1) {
+    return rfind_char<CharT, Traits>(is_bytewise<CharT, Traits>(), h, n, x[0]);
+  }
+  if (m > two_way_threshold) {
+    const size_t r = two_way<Traits>(reverse_seq<CharT>{h + n - 1}, static_cast<ptrdiff_t>(n),
+                                     reverse_seq<CharT>{x + m - 1}, static_cast<ptrdiff_t>(m));
+    return r == not_found ? not_found : n - m - r;
+  }
+  return rsearch_short<CharT, Traits>(is_bytewise<CharT, Traits>(), h, n, x, m);
+}
+
+/// @brief Offset of the last @p c in [h, h + n).
+template <class CharT, class Traits>
+constexpr size_t rfind_char (const CharT *h, size_t n, CharT c) noexcept {
+  if (cpu::constant_evaluated()) { return rfind_char_scalar<CharT, Traits>(h, n, c); }
+  return rfind_char<CharT, Traits>(is_bytewise<CharT, Traits>(), h, n, c);
+}
+
+
+}  // namespace detail
+}  // namespace str
+}  // namespace omtl
+
+#endif  // OMTL_STR_SEARCH_H
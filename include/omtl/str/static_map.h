@@ -0,0 +1,240 @@
+#pragma once
+
+#ifndef OMTL_STR_STATIC_MAP_H
+#define OMTL_STR_STATIC_MAP_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <omtl/str/icase.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+namespace detail {
+
+
+/// FNV-1a over the code units, finished with the splitmix64 mixer: cheap
+/// on short keywords and evaluable at compile time. Under ascii_icase_traits
+/// the units are lowered first, so keys equal without case share a slot.
+constexpr uint64_t static_mix (uint64_t z) noexcept {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+template <class CharT, class Traits>
+constexpr uint64_t static_hash (basic_view<CharT, Traits> str) noexcept {
+  uint64_t h = 0xCBF29CE484222325ull;
+  for (size_t i = 0; i < str.size(); ++i) {
+    const CharT c = is_icase_traits<Traits>::value ? ascii_lower(str[i]) : str[i];
+    h = (h ^ static_cast<uint64_t>(static_cast<std::make_unsigned_t<CharT>>(c))) * 0x100000001B3ull;
+  }
+  return static_mix(h ^ str.size());
+}
+
+/// Slot of a key with hash @p h under its bucket's displacement @p d.
+constexpr size_t static_slot (uint64_t h, uint32_t d, size_t mask) noexcept {
+  return static_cast<size_t>(static_mix(h ^ (d * 0x9E3779B97F4A7C15ull))) & mask;
+}
+
+constexpr size_t ceil_pow2 (size_t n) noexcept {
+  size_t p = 1;
+  while (p < n) { p <<= 1; }
+  return p;
+}
+
+
+}  // namespace detail
+
+
+/// @class Perfect-hash set of @p N strings, built at compile time from sv
+///        literals. Keys are hashed into buckets, and each bucket gets a
+///        displacement that sends its keys to free slots of a table twice
+///        the key count; buckets are placed largest first. A lookup is one
+///        hash, two table reads and one comparison, with no runtime setup
+///        when the set is constexpr. index_of() gives the key's position in
+///        the constructor's list, usable as a keyword id.
+///        The keys are views: literals, or strings outliving the set.
+template <class CharT, size_t N, class Traits = std::char_traits<CharT>>
+class basic_static_set {
+public:
+  using view_type = basic_view<CharT, Traits>;
+  using size_type = size_t;
+
+  using const_iterator = const view_type *;
+
+  static constexpr size_type npos = size_type(-1);
+
+  static constexpr size_type table_size   = detail::ceil_pow2(2 * N);
+  static constexpr size_type bucket_count = detail::ceil_pow2(N);
+
+  /// Displacements tried per bucket before giving up.
+  static constexpr uint32_t max_displacement = 1u << 16;
+
+  static_assert(N > 0, "a static set has keys");
+
+  /// @throw std::invalid_argument on duplicate keys, which fails
+  ///        compilation when the set is constexpr.
+  constexpr explicit basic_static_set (const view_type (&keys)[N]) : _keys(), _slots(), _disp() {
+    for (size_type i = 0; i < N; ++i) { _keys[i] = keys[i]; }
+    build();
+  }
+
+  /// @brief Set of the keys of map entries.
+  template <class V>
+  constexpr explicit basic_static_set (const std::pair<view_type, V> (&entries)[N]) : _keys(), _slots(), _disp() {
+    for (size_type i = 0; i < N; ++i) { _keys[i] = entries[i].first; }
+    build();
+  }
+
+  /// @brief Position of @p key in the constructor's list, or npos.
+  constexpr size_type index_of (view_type key) const noexcept {
+    const uint64_t h    = detail::static_hash(key);
+    const uint32_t slot = _slots[detail::static_slot(h, _disp[h & (bucket_count - 1)], table_size - 1)];
+    if (slot == 0) { return npos; }
+    const view_type &found = _keys[slot - 1];
+    return found.size() == key.size() && Traits::compare(found.data(), key.data(), key.size()) == 0 ? slot - 1 : npos;
+  }
+
+  constexpr bool contains (view_type key) const noexcept { return index_of(key) != npos; }
+
+  constexpr size_type size (void) const noexcept { return N; }
+
+  constexpr const view_type &operator[] (size_type index) const noexcept { return _keys[index]; }
+
+  constexpr const_iterator begin (void) const noexcept { return _keys; }
+  constexpr const_iterator end   (void) const noexcept { return _keys + N; }
+
+private:
+  constexpr void build (void) {
+    uint64_t  hashes[N]              = { };
+    size_type in_bucket[bucket_count] = { };
+    size_type largest                = 0;
+    for (size_type i = 0; i < N; ++i) {
+      hashes[i] = detail::static_hash(_keys[i]);
+      for (size_type j = 0; j < i; ++j) {
+        if (hashes[j] == hashes[i] && _keys[j] == _keys[i]) { throw std::invalid_argument("omtl::str::basic_static_set: duplicate key"); }
+      }
+      const size_type b = hashes[i] & (bucket_count - 1);
+      if (++in_bucket[b] > largest) { largest = in_bucket[b]; }
+    }
+
+    for (size_type count = largest; count > 0; --count) {
+      for (size_type b = 0; b < bucket_count; ++b) {
+        if (in_bucket[b] == count) { place(b, hashes); }
+      }
+    }
+  }
+
+  /// Finds the first displacement sending every key of bucket @p b to a
+  /// free slot, distinct from the slots of the bucket's other keys.
+  constexpr void place (size_type b, const uint64_t (&hashes)[N]) {
+    size_type taken[N] = { };
+    for (uint32_t d = 0; d < max_displacement; ++d) {
+      size_type placed = 0;
+      bool      fits   = true;
+      for (size_type i = 0; i < N && fits; ++i) {
+        if ((hashes[i] & (bucket_count - 1)) != b) { continue; }
+        const size_type slot = detail::static_slot(hashes[i], d, table_size - 1);
+        fits = _slots[slot] == 0;
+        for (size_type k = 0; k < placed && fits; ++k) { fits = taken[k] != slot; }
+        taken[placed++] = slot;
+      }
+      if (!fits) { continue; }
+
+      placed = 0;
+      for (size_type i = 0; i < N; ++i) {
+        if ((hashes[i] & (bucket_count - 1)) == b) { _slots[taken[placed++]] = static_cast<uint32_t>(i + 1); }
+      }
+      _disp[b] = d;
+      return;
+    }
+    throw std::logic_error("omtl::str::basic_static_set: no displacement found");
+  }
+
+  view_type _keys[N];
+  uint32_t  _slots[table_size];  ///< Key index + 1, zero marks a free slot.
+  uint32_t  _disp[bucket_count];
+};
+
+
+/// @class Perfect-hash map from @p N strings to values of type @p V, built
+///        at compile time like basic_static_set. @p V must be a literal,
+///        default-constructible type for the map to be constexpr.
+template <class CharT, class V, size_t N, class Traits = std::char_traits<CharT>>
+class basic_static_map {
+public:
+  using view_type   = basic_view<CharT, Traits>;
+  using mapped_type = V;
+  using entry_type  = std::pair<view_type, V>;
+  using size_type   = size_t;
+  using key_set     = basic_static_set<CharT, N, Traits>;
+
+  static constexpr size_type npos = key_set::npos;
+
+  constexpr explicit basic_static_map (const entry_type (&entries)[N]) : _keys(entries), _values() {
+    for (size_type i = 0; i < N; ++i) { _values[i] = entries[i].second; }
+  }
+
+  /// @brief Value of @p key, or nullptr.
+  constexpr const V *find (view_type key) const noexcept {
+    const size_type i = _keys.index_of(key);
+    return i != npos ? &_values[i] : nullptr;
+  }
+
+  constexpr V value_or (view_type key, V fallback) const {
+    const size_type i = _keys.index_of(key);
+    return i != npos ? _values[i] : fallback;
+  }
+
+  constexpr const V &at (view_type key) const {
+    const size_type i = _keys.index_of(key);
+    if (i == npos) { throw std::out_of_range("omtl::str::basic_static_map"); }
+    return _values[i];
+  }
+
+  constexpr bool      contains (view_type key) const noexcept { return _keys.contains(key); }
+  constexpr size_type index_of (view_type key) const noexcept { return _keys.index_of(key); }
+  constexpr size_type size     (void)          const noexcept { return N; }
+
+  constexpr const key_set &keys (void) const noexcept { return _keys; }
+
+private:
+  key_set _keys;
+  V       _values[N];
+};
+
+
+template <size_t N>
+using static_set = basic_static_set<char, N>;
+
+template <class V, size_t N>
+using static_map = basic_static_map<char, V, N>;
+
+
+/// @brief Set of sv literals with the count deduced:
+///        constexpr auto methods = make_static_set({ "GET"sv, "PUT"sv });
+template <class CharT, class Traits, size_t N>
+constexpr basic_static_set<CharT, N, Traits> make_static_set (const basic_view<CharT, Traits> (&keys)[N]) {
+  return basic_static_set<CharT, N, Traits>(keys);
+}
+
+/// @brief Map with the count deduced:
+///        constexpr auto codes = make_static_map<int>({ { "OK"sv, 200 }, { "Not Found"sv, 404 } });
+template <class V, class CharT = char, class Traits = std::char_traits<CharT>, size_t N>
+constexpr basic_static_map<CharT, V, N, Traits> make_static_map (const std::pair<basic_view<CharT, Traits>, V> (&entries)[N]) {
+  return basic_static_map<CharT, V, N, Traits>(entries);
+}
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_STATIC_MAP_H
@@ -6,94 +6,256 @@
 
 #include <vector>
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 #include <omtl/memory.h>
 #include <omtl/utils/flags.h>
 #include <omtl/str/view.h>
-#include <omtl/str/algorithms.h>
+#include <omtl/str/hash.h>
+#include <omtl/str/algorithm.h>
 
 
 namespace omtl {
 namespace str {
 
 
+template <class CharT, class Traits, size_t Shards>
+class concurrent_storage;
+
+template <class CharT, class Traits>
+class mapped_storage;
+
+
+/// @class Compact reference to a string kept in a storage: the 1-based
+///        index of its entry, resolved back to a view in O(1). Interned
+///        strings get one handle per distinct value, so comparing handles
+///        is comparing strings; otherwise handles compare by identity.
+class string_handle {
+public:
+  using id_type = uint32_t;
+
+  constexpr string_handle (void) noexcept = default;
+  constexpr explicit string_handle (id_type id) noexcept : _id(id) { }
+
+  constexpr id_type id (void) const noexcept { return _id; }
+  constexpr explicit operator bool (void) const noexcept { return _id != 0; }
+
+  friend constexpr bool operator == (string_handle a, string_handle b) noexcept { return a._id == b._id; }
+  friend constexpr bool operator != (string_handle a, string_handle b) noexcept { return a._id != b._id; }
+  friend constexpr bool operator <  (string_handle a, string_handle b) noexcept { return a._id <  b._id; }
+
+private:
+  id_type _id = 0;
+};
+
+
+/// @class String pool. Strings are copied into arena blocks and stay at a
+///        fixed address until clear() or reset(). With alloc_enable blocks
+///        grow geometrically from @p size up to @p max_block characters, and
+///        strings over a quarter of @p max_block get a dedicated block of
+///        their own.
 template <class CharT = char, class Traits = std::char_traits<CharT>>
 class storage {
 public:
-  using string_type = basic_string_view<CharT, Traits>;
+  using string_type = basic_view<CharT, Traits>;
 
   enum class settings {
-    mem_optimize,
-    alloc_enable,
+    mem_optimize,  ///< Reuse any stored string that contains the added one (linear scan).
+    alloc_enable,  ///< Allocate additional blocks once the first one is full.
+    intern,        ///< Deduplicate equal strings through a hash index, O(1) expected.
 
     __SENTINEL__
   };
   using settings_flags = omtl::flags<settings>;
 
-  storage (size_t size, settings_flags s = settings_flags());
+  static constexpr size_t default_max_block = size_t(1) << 20;
+
+  storage (size_t size, settings_flags s = settings_flags(), size_t max_block = default_max_block);
+
+  string_type add  (not_null<string_type> str);
+  string_type find (string_type str) const;
+  string_type find (const basic_hashed_view<CharT, Traits> &str) const;
+  string_type get  (ptrdiff_t offset, size_t sz);
+
+  /// @brief Stores like add() and returns a handle. Every stored string
+  ///        gets one, whichever block it ends up in.
+  string_handle store     (not_null<string_type> str);
+  string_handle handle_of (string_type str) const;
+  string_handle handle_of (const basic_hashed_view<CharT, Traits> &str) const;
+  string_type   get       (string_handle h) const { assert(h && h.id() <= _entries.size()); return resolve(_entries[h.id() - 1]); }
+
+  /// @brief @p n uninitialized characters from the blocks, neither indexed
+  ///        nor reclaimed before clear(). Backs storage_allocator; do not
+  ///        combine with mem_optimize, which would scan them.
+  CharT *allocate (size_t n);
 
-  string_type add (not_null<string_type> str);
-  string_type get (ptrdiff_t offset, size_t sz);
+  /// @brief Forgets every string but keeps the regular blocks for reuse.
+  void clear (void);
+  /// @brief Forgets every string and frees all blocks except the first one.
+  void reset (void);
+
+  size_t capacity (void) const noexcept;
 
 private:
+  template <class, class, size_t>
+  friend class concurrent_storage;
+  template <class, class>
+  friend class mapped_storage;
+
   struct block_t {
-    block_t (size_t sz) : data(sz, CharT()), str(data.data(), 0) { }
+    block_t (size_t sz, bool single = false) : data(new CharT[sz]), size(sz), dedicated(single) { }
+
+    std::unique_ptr<CharT[]> data;
+    size_t                   size;
+    size_t                   used = 0;
+    bool                     dedicated;
+
+    const CharT *begin   (void)          const { return data.get(); }
+    string_type  str     (void)          const { return string_type(data.get(), used); }
+    bool         capable (size_t n)      const { return n <= size - used; }
+    CharT       *take    (size_t n)            { CharT *pos = data.get() + used; used += n; return pos; }
+  };
 
-    std::vector<CharT> data;
-    string_type        str;
+  /// Index entry: location of an interned string and its hash, so that
+  /// growing the table never re-reads string data.
+  struct entry_t {
+    uint32_t block;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t hash;
+  };
 
-    const CharT *data    (void)          const { return data.data(); }
-    bool         capable (string_type s) const { return s.length() < data.size() - str.length(); }
-    string_type  add     (string_type s);
+  /// Open-addressing slot; the hash copy rejects most mismatches without
+  /// touching the entry. @c entry is index + 1, zero marks an empty slot.
+  struct slot_t {
+    uint32_t hash;
+    uint32_t entry;
   };
 
-  block_t              _data;
-  std::vector<block_t> _additional;
-  settings_flags       _flags;
+  static uint32_t hash_of (string_type str) noexcept { return static_cast<uint32_t>(omtl::str::hash_of(str)); }
+
+  const block_t &block_at (size_t index) const { return *_blocks[index]; }
+
+  string_type resolve      (const entry_t &e) const { return string_type(block_at(e.block).begin() + e.offset, e.length); }
+  string_type insert       (string_type str, uint32_t h, bool record, uint32_t &id);
+  uint32_t    lookup       (string_type str, uint32_t h) const;
+  string_type find         (string_type str, uint32_t h) const;
+  string_type find_shared  (string_type str, uint32_t &block) const;
+  string_type append       (string_type str, uint32_t &block);
+  CharT      *reserve      (size_t n, uint32_t &block);
+  uint32_t    index        (string_type stored, uint32_t block, uint32_t h, bool hashed);
+  void        grow_index   (void);
+
+  std::vector<owner<block_t>> _blocks;
+  size_t                      _current = 0;
+  size_t                      _max_block;
+  settings_flags              _flags;
+
+  std::vector<entry_t> _entries;
+  std::vector<slot_t>  _slots;
 };
 
 
 template<class CharT, class Traits>
-inline storage<CharT, Traits>::storage(size_t size, settings_flags s)
-  : _data(size)
+inline storage<CharT, Traits>::storage(size_t size, settings_flags s, size_t max_block)
+  : _max_block(max_block)
   , _flags(s)
-{ }
+{
+  _blocks.emplace_back(new block_t(size));
+}
+
+
+template <class CharT, class Traits>
+typename storage<CharT, Traits>::string_type
+storage<CharT, Traits>::add (not_null<typename storage<CharT, Traits>::string_type> str) {
+  const string_type s = str.get();
+  uint32_t id;
+  return insert(s, _flags.test(settings::intern) ? hash_of(s) : 0, false, id);
+}
 
 
-#define TRY_FIND_IN_BLOCK(_Block, _Str) {    \
-  size_t existing = _Block.str.find(_Str);   \
-  if (existing != string_type::npos) {       \
-    CharT *pos = _data.data() + existing;    \
-    return string_type(pos, (_Str).length(); \
-  }                                          \
+template <class CharT, class Traits>
+string_handle storage<CharT, Traits>::store (not_null<typename storage<CharT, Traits>::string_type> str) {
+  const string_type s = str.get();
+  uint32_t id;
+  insert(s, _flags.test(settings::intern) ? hash_of(s) : 0, true, id);
+  return string_handle(id);
 }
 
+
+/// @brief Handle of an interned string, or a null handle. Requires intern.
+template <class CharT, class Traits>
+string_handle storage<CharT, Traits>::handle_of (string_type str) const {
+  assert(_flags.test(settings::intern));
+  return string_handle(lookup(str, hash_of(str)));
+}
+
+
+/// @brief handle_of() reusing the hash the view carries.
+template <class CharT, class Traits>
+string_handle storage<CharT, Traits>::handle_of (const basic_hashed_view<CharT, Traits> &str) const {
+  assert(_flags.test(settings::intern));
+  return string_handle(lookup(str.view(), static_cast<uint32_t>(str.hash())));
+}
+
+
 template <class CharT, class Traits>
 typename storage<CharT, Traits>::string_type
-storage<CharT, Traits>::add (not_null<typename storage<CharT, Traits>::string_type> str) {
-  if (_flags.test(settings::mem_optimize) {
-    TRY_FIND_IN_BLOCK(_data, str);
-    if (_flags.test(settings::alloc_enable)) {
-      for (auto &block : _blocks)
-        TRY_FIND_IN_BLOCK(block, str);
-    }
+storage<CharT, Traits>::insert (string_type s, uint32_t h, bool record, uint32_t &id) {
+  const bool interning = _flags.test(settings::intern);
+  if (interning) {
+    id = lookup(s, h);
+    if (id) { return resolve(_entries[id - 1]); }
   }
 
-  if (_data.capable(str)) {
-    return _data.add(str);
+  uint32_t block = 0;
+  string_type stored;
+  if (_flags.test(settings::mem_optimize)) {
+    stored = find_shared(s, block);
   }
-  if (_flags.test(settings::alloc_enable)) {
-    if (_blocks.empty() || !_blocks.back().capable(str)) {
-      _blocks.emplace_back();
-    }
-    return _blocks.back().add(str);
+  if (!stored.data()) {
+    stored = append(s, block);
   }
+  id = stored.data() && (interning || record) ? index(stored, block, h, interning) : 0;
+  return stored;
+}
+
 
-  assert(false);
-  return typename storage<CharT, Traits>::string_type();
+/// @brief Looks a string up without storing it. Uses the hash index when
+///        interning, otherwise the substring scan if mem_optimize is set.
+template <class CharT, class Traits>
+typename storage<CharT, Traits>::string_type
+storage<CharT, Traits>::find (string_type str) const {
+  return find(str, _flags.test(settings::intern) ? hash_of(str) : 0);
+}
+
+
+/// @brief find() reusing the hash the view carries.
+template <class CharT, class Traits>
+typename storage<CharT, Traits>::string_type
+storage<CharT, Traits>::find (const basic_hashed_view<CharT, Traits> &str) const {
+  return find(str.view(), static_cast<uint32_t>(str.hash()));
 }
 
-#undef TRY_FIND_IN_BLOCK
+
+template <class CharT, class Traits>
+typename storage<CharT, Traits>::string_type
+storage<CharT, Traits>::find (string_type str, uint32_t h) const {
+  if (_flags.test(settings::intern)) {
+    const uint32_t id = lookup(str, h);
+    if (id) { return resolve(_entries[id - 1]); }
+  }
+  if (_flags.test(settings::mem_optimize)) {
+    uint32_t block;
+    return find_shared(str, block);
+  }
+  return string_type();
+}
 
 
 template<class CharT, class Traits>
@@ -101,22 +263,198 @@ inline typename storage<CharT, Traits>::string_type
 storage<CharT, Traits>::get (ptrdiff_t offset, size_t sz)
 {
   assert(!_flags.test(settings::alloc_enable));
-  return string_type(_data.data() + offset, sz);
+  return string_type(_blocks.front()->begin() + offset, sz);
 }
 
 
-template<class CharT, class Traits>
+template <class CharT, class Traits>
+void storage<CharT, Traits>::clear (void) {
+  _blocks.erase(std::remove_if(_blocks.begin(), _blocks.end(),
+                               [] (const owner<block_t> &b) { return b->dedicated; }),
+                _blocks.end());
+  for (auto &block : _blocks) { block->used = 0; }
+  _current = 0;
+  _entries.clear();
+  std::fill(_slots.begin(), _slots.end(), slot_t{ 0, 0 });
+}
+
+
+template <class CharT, class Traits>
+void storage<CharT, Traits>::reset (void) {
+  _blocks.resize(1);
+  clear();
+}
+
+
+template <class CharT, class Traits>
+size_t storage<CharT, Traits>::capacity (void) const noexcept {
+  size_t total = 0;
+  for (const auto &block : _blocks) { total += block->size; }
+  return total;
+}
+
+
+template <class CharT, class Traits>
+uint32_t storage<CharT, Traits>::lookup (string_type str, uint32_t h) const {
+  if (_slots.empty()) { return 0; }
+  const size_t mask = _slots.size() - 1;
+  for (size_t i = h & mask; _slots[i].entry != 0; i = (i + 1) & mask) {
+    if (_slots[i].hash != h) { continue; }
+    const entry_t &e = _entries[_slots[i].entry - 1];
+    if (e.length == str.length() &&
+        Traits::compare(block_at(e.block).begin() + e.offset, str.data(), str.length()) == 0) {
+      return _slots[i].entry;
+    }
+  }
+  return 0;
+}
+
+
+template <class CharT, class Traits>
 typename storage<CharT, Traits>::string_type
-storage<CharT, Traits>::block_t::add (typename storage<CharT, Traits>::string_type s) {
-  auto pos = data.data() + str.length();
-  Traits::copy(pos, s.data(), s.length());
-  str = string_type(data.data(), str.length() + s.length() + 1);
-  return string_type(pos, s.length);
+storage<CharT, Traits>::find_shared (string_type str, uint32_t &block) const {
+  for (size_t b = 0; b < _blocks.size(); ++b) {
+    size_t existing = block_at(b).str().find(str);
+    if (existing != string_type::npos) {
+      block = static_cast<uint32_t>(b);
+      return string_type(block_at(b).begin() + existing, str.length());
+    }
+  }
+  return string_type();
+}
+
+
+template <class CharT, class Traits>
+CharT *storage<CharT, Traits>::allocate (size_t n) {
+  uint32_t block;
+  CharT *pos = reserve(n, block);
+  if (!pos) { throw std::bad_alloc(); }
+  return pos;
+}
+
+
+template <class CharT, class Traits>
+typename storage<CharT, Traits>::string_type
+storage<CharT, Traits>::append (string_type str, uint32_t &block) {
+  CharT *pos = reserve(str.length() + 1, block);
+  if (!pos) {
+    assert(false);
+    return string_type();
+  }
+  Traits::copy(pos, str.data(), str.length());
+  pos[str.length()] = CharT();
+  return string_type(pos, str.length());
 }
 
 
+/// @brief Room for @p n characters, or nullptr if the blocks are full and
+///        alloc_enable is not set.
+template <class CharT, class Traits>
+CharT *storage<CharT, Traits>::reserve (size_t n, uint32_t &block) {
+  if (!_blocks[_current]->capable(n) && _flags.test(settings::alloc_enable)) {
+    const size_t largest = std::max(_blocks[_current]->size, _max_block);
+    size_t       next    = std::max(_blocks[_current]->size, std::min(_blocks[_current]->size * 2, _max_block));
+
+    // Big requests get an exact-size block so the current one keeps its tail.
+    if (n > largest / 4) {
+      _blocks.emplace_back(new block_t(n, true));
+      block = static_cast<uint32_t>(_blocks.size() - 1);
+      return _blocks.back()->take(n);
+    }
+    // Anything smaller grows the regular blocks until it fits in one.
+    while (next < n) { next = std::min(next * 2, largest); }
+
+    // Blocks kept by clear() are refilled before anything new is allocated.
+    size_t reuse = _current + 1;
+    while (reuse < _blocks.size() && (_blocks[reuse]->dedicated || !_blocks[reuse]->capable(n))) { ++reuse; }
+    if (reuse == _blocks.size()) {
+      _blocks.emplace_back(new block_t(next));
+    }
+    _current = reuse;
+  }
+
+  if (_blocks[_current]->capable(n)) {
+    block = static_cast<uint32_t>(_current);
+    return _blocks[_current]->take(n);
+  }
+  return nullptr;
+}
+
+
+template <class CharT, class Traits>
+uint32_t storage<CharT, Traits>::index (string_type stored, uint32_t block, uint32_t h, bool hashed) {
+  _entries.push_back({ block,
+                       static_cast<uint32_t>(stored.data() - block_at(block).begin()),
+                       static_cast<uint32_t>(stored.length()),
+                       h });
+  const uint32_t id = static_cast<uint32_t>(_entries.size());
+  if (!hashed) { return id; }
+
+  if ((_entries.size() + 1) * 4 > _slots.size() * 3) {
+    grow_index();
+    return id;
+  }
+  const size_t mask = _slots.size() - 1;
+  size_t i = h & mask;
+  while (_slots[i].entry != 0) { i = (i + 1) & mask; }
+  _slots[i] = { h, id };
+  return id;
+}
+
+
+template <class CharT, class Traits>
+void storage<CharT, Traits>::grow_index (void) {
+  std::vector<slot_t> slots(std::max<size_t>(16, _slots.size() * 2), slot_t{ 0, 0 });
+  const size_t mask = slots.size() - 1;
+  for (size_t e = 0; e < _entries.size(); ++e) {
+    size_t i = _entries[e].hash & mask;
+    while (slots[i].entry != 0) { i = (i + 1) & mask; }
+    slots[i] = { _entries[e].hash, static_cast<uint32_t>(e + 1) };
+  }
+  _slots.swap(slots);
+}
+
+
+/// @class Allocator drawing characters from a storage's blocks, e.g. for
+///        basic_string. Deallocation is a no-op: the memory comes back with
+///        the storage's clear() or reset(). Equal iff they share a storage.
+template <class CharT = char, class Traits = std::char_traits<CharT>>
+class storage_allocator {
+public:
+  using value_type   = CharT;
+  using storage_type = storage<CharT, Traits>;
+
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap            = std::true_type;
+
+  storage_allocator (storage_type &s) noexcept : _storage(&s) { }
+
+  CharT *allocate   (size_t n) { return _storage->allocate(n); }
+  void   deallocate (CharT *, size_t) noexcept { }
+
+  storage_type &source (void) const noexcept { return *_storage; }
+
+  friend bool operator == (const storage_allocator &a, const storage_allocator &b) noexcept { return a._storage == b._storage; }
+  friend bool operator != (const storage_allocator &a, const storage_allocator &b) noexcept { return a._storage != b._storage; }
+
+private:
+  storage_type *_storage;
+};
+
+
 }  // namespace str
 }  // namespace omtl
 
 
+namespace std {
+
+template <>
+struct hash<omtl::str::string_handle> {
+  size_t operator() (omtl::str::string_handle h) const noexcept { return std::hash<uint32_t>()(h.id()); }
+};
+
+}  // namespace std
+
+
 #endif  // OMTL_STR_STORAGE_H
@@ -0,0 +1,421 @@
+#pragma once
+
+#ifndef OMTL_STR_STRING_H
+#define OMTL_STR_STRING_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <omtl/str/view.h>
+#include <omtl/str/hash.h>
+
+
+namespace omtl {
+namespace str {
+
+
+/// @class Owning string with a 23-character inline buffer on 64-bit
+///        targets: the whole object is three words, and short strings never
+///        allocate. The last byte of the object tags the representation:
+///        inline strings keep their unused capacity there, so a full inline
+///        buffer ends with the zero that terminates it. Heap strings set a
+///        bit there that is out of range for inline ones, and give it up
+///        from their capacity word.
+///        Converts to basic_view without copying; the search and compare
+///        operations are basic_view's.
+template <class CharT, class Traits = std::char_traits<CharT>, class Alloc = std::allocator<CharT>>
+class basic_string {
+public:
+  using traits_type    = Traits;
+  using value_type     = CharT;
+  using allocator_type = Alloc;
+  using view_type      = basic_view<CharT, Traits>;
+
+  using       pointer   =       CharT*;
+  using const_pointer   = const CharT*;
+  using       reference =       CharT&;
+  using const_reference = const CharT&;
+
+  using iterator               = pointer;
+  using const_iterator         = const_pointer;
+  using reverse_iterator       = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  using size_type       = size_t;
+  using difference_type = ptrdiff_t;
+
+  static constexpr size_type npos = size_type(-1);
+
+private:
+  using alloc_traits = std::allocator_traits<Alloc>;
+
+  struct heap_t {
+    CharT     *data;
+    size_type  size;
+    size_type  cap;  ///< Encoded, see encode_cap().
+  };
+
+  static constexpr size_type rep_bytes = sizeof(heap_t);
+
+public:
+  /// Characters that fit without allocating, not counting the terminator.
+  static constexpr size_type inline_capacity = rep_bytes / sizeof(CharT) - 1;
+
+  basic_string (void) noexcept(noexcept(Alloc())) : _impl() { set_inline_size(0); }
+  explicit basic_string (const Alloc &a) noexcept : _impl(a) { set_inline_size(0); }
+
+  basic_string (const CharT *s, const Alloc &a = Alloc())
+    : _impl(a) { init(s, Traits::length(s)); }
+  basic_string (const CharT *s, size_type n, const Alloc &a = Alloc())
+    : _impl(a) { init(s, n); }
+  explicit basic_string (view_type s, const Alloc &a = Alloc())
+    : _impl(a) { init(s.data(), s.size()); }
+  basic_string (size_type n, CharT c, const Alloc &a = Alloc())
+    : _impl(a) { set_inline_size(0); append(n, c); }
+
+  basic_string (const basic_string &o)
+    : _impl(alloc_traits::select_on_container_copy_construction(o.alloc())) { init(o.data(), o.size()); }
+  basic_string (const basic_string &o, const Alloc &a)
+    : _impl(a) { init(o.data(), o.size()); }
+
+  basic_string (basic_string &&o) noexcept
+    : _impl(std::move(o.alloc())) { steal(o); }
+
+  ~basic_string (void) { release(); }
+
+  basic_string &operator= (const basic_string &o) {
+    if (this == &o) { return *this; }
+    if (alloc_traits::propagate_on_container_copy_assignment::value && alloc() != o.alloc()) {
+      release();
+      set_inline_size(0);
+      alloc() = o.alloc();
+    }
+    return assign(o.data(), o.size());
+  }
+
+  basic_string &operator= (basic_string &&o) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                      alloc_traits::is_always_equal::value) {
+    if (this == &o) { return *this; }
+    if (!alloc_traits::propagate_on_container_move_assignment::value && alloc() != o.alloc()) {
+      return assign(o.data(), o.size());
+    }
+    release();
+    if (alloc_traits::propagate_on_container_move_assignment::value) { alloc() = std::move(o.alloc()); }
+    steal(o);
+    return *this;
+  }
+
+  basic_string &operator= (view_type s)    { return assign(s.data(), s.size()); }
+  basic_string &operator= (const CharT *s) { return assign(s, Traits::length(s)); }
+
+  allocator_type get_allocator (void) const noexcept { return alloc(); }
+
+
+  iterator         begin  (void)       noexcept { return ptr(); }
+  const_iterator   begin  (void) const noexcept { return ptr(); }
+  iterator         end    (void)       noexcept { return ptr() + size(); }
+  const_iterator   end    (void) const noexcept { return ptr() + size(); }
+  reverse_iterator rbegin (void)       noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend   (void)       noexcept { return reverse_iterator(begin()); }
+
+  const_iterator         cbegin  (void) const noexcept { return begin(); }
+  const_iterator         cend    (void) const noexcept { return end(); }
+  const_reverse_iterator crbegin (void) const noexcept { return const_reverse_iterator(cend()); }
+  const_reverse_iterator crend   (void) const noexcept { return const_reverse_iterator(cbegin()); }
+
+  size_type size     (void) const noexcept { return is_inline() ? inline_capacity - (tag() >> tag_shift) : _impl.rep.heap.size; }
+  size_type length   (void) const noexcept { return size(); }
+  size_type capacity (void) const noexcept { return is_inline() ? inline_capacity : decode_cap(_impl.rep.heap.cap); }
+  size_type max_size (void) const noexcept {
+    return std::min<size_type>(alloc_traits::max_size(alloc()) - 1, std::numeric_limits<size_type>::max() >> 1);
+  }
+  bool      empty    (void) const noexcept { return size() == 0; }
+
+  /// @brief Whether the characters live in the object itself.
+  bool is_inline (void) const noexcept { return !(tag() & heap_bit); }
+
+  reference       operator[] (size_type pos)       { return ptr()[pos]; }
+  const_reference operator[] (size_type pos) const { return ptr()[pos]; }
+  reference       at         (size_type pos)       { validate(pos); return ptr()[pos]; }
+  const_reference at         (size_type pos) const { validate(pos); return ptr()[pos]; }
+
+  reference       front (void)       { return ptr()[0]; }
+  const_reference front (void) const { return ptr()[0]; }
+  reference       back  (void)       { return ptr()[size() - 1]; }
+  const_reference back  (void) const { return ptr()[size() - 1]; }
+
+  CharT       *data  (void)       noexcept { return ptr(); }
+  const CharT *data  (void) const noexcept { return ptr(); }
+  const CharT *c_str (void) const noexcept { return ptr(); }
+
+  view_type view (void) const noexcept { return view_type(ptr(), size()); }
+  operator view_type (void) const noexcept { return view(); }
+
+
+  void reserve (size_type n) {
+    if (n <= capacity()) { return; }
+    const size_type sz = size();
+    CharT *p = allocate(n);
+    Traits::copy(p, ptr(), sz);
+    adopt(p, sz, n);
+  }
+
+  /// @brief Moves a heap string that has become short back inline.
+  void shrink_to_fit (void) {
+    if (is_inline() || size() > inline_capacity) { return; }
+    const heap_t heap = _impl.rep.heap;
+    Traits::copy(_impl.rep.buf, heap.data, heap.size);
+    set_inline_size(heap.size);
+    alloc_traits::deallocate(alloc(), heap.data, decode_cap(heap.cap) + 1);
+  }
+
+  void clear (void) noexcept { set_size(0); }
+
+  void resize (size_type n, CharT c = CharT()) {
+    const size_type sz = size();
+    if (n > sz) { append(n - sz, c); } else { set_size(n); }
+  }
+
+  void push_back (CharT c) { append(&c, 1); }
+  void pop_back  (void)    { set_size(size() - 1); }
+
+
+  basic_string &assign (const CharT *s, size_type n) {
+    if (n <= capacity()) {
+      Traits::move(ptr(), s, n);
+      set_size(n);
+      return *this;
+    }
+    const size_type cap = grown_capacity(n);
+    CharT *p = allocate(cap);
+    Traits::copy(p, s, n);
+    adopt(p, n, cap);
+    return *this;
+  }
+  basic_string &assign (view_type s) { return assign(s.data(), s.size()); }
+
+  basic_string &append (const CharT *s, size_type n) {
+    const size_type sz = size();
+    if (n <= capacity() - sz) {
+      Traits::move(ptr() + sz, s, n);
+      set_size(sz + n);
+      return *this;
+    }
+    // The old buffer is released last, so @p s may point into it.
+    const size_type cap = grown_capacity(sz + n);
+    CharT *p = allocate(cap);
+    Traits::copy(p, ptr(), sz);
+    Traits::copy(p + sz, s, n);
+    adopt(p, sz + n, cap);
+    return *this;
+  }
+  basic_string &append (view_type s)    { return append(s.data(), s.size()); }
+  basic_string &append (const CharT *s) { return append(s, Traits::length(s)); }
+  basic_string &append (size_type n, CharT c) {
+    const size_type sz = size();
+    if (n > capacity() - sz) { reserve(grown_capacity(sz + n)); }
+    Traits::assign(ptr() + sz, n, c);
+    set_size(sz + n);
+    return *this;
+  }
+
+  basic_string &operator+= (view_type s)    { return append(s); }
+  basic_string &operator+= (const CharT *s) { return append(s); }
+  basic_string &operator+= (CharT c)        { push_back(c); return *this; }
+
+  void swap (basic_string &o) noexcept {
+    if (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(alloc(), o.alloc());
+    }
+    std::swap(_impl.rep, o._impl.rep);
+  }
+
+
+  basic_string substr (size_type pos = 0, size_type n = npos) const {
+    if (pos > size()) { throw std::out_of_range("omtl::str::basic_string"); }
+    return basic_string(ptr() + pos, std::min(n, size() - pos), alloc());
+  }
+
+  int compare (view_type s) const noexcept { return view().compare(s); }
+
+  size_type find              (view_type s, size_type pos = 0)    const noexcept { return view().find(s, pos); }
+  size_type find              (CharT c,     size_type pos = 0)    const noexcept { return view().find(c, pos); }
+  size_type rfind             (view_type s, size_type pos = npos) const noexcept { return view().rfind(s, pos); }
+  size_type rfind             (CharT c,     size_type pos = npos) const noexcept { return view().rfind(c, pos); }
+  size_type find_first_of     (view_type s, size_type pos = 0)    const noexcept { return view().find_first_of(s, pos); }
+  size_type find_last_of      (view_type s, size_type pos = npos) const noexcept { return view().find_last_of(s, pos); }
+  size_type find_first_not_of (view_type s, size_type pos = 0)    const noexcept { return view().find_first_not_of(s, pos); }
+  size_type find_last_not_of  (view_type s, size_type pos = npos) const noexcept { return view().find_last_not_of(s, pos); }
+
+
+#define IMPL_OPERATOR(_Op)                                                                                       \
+  friend bool operator _Op (const basic_string &x, const basic_string &y) noexcept { return x.view() _Op y.view(); } \
+  friend bool operator _Op (const basic_string &x, view_type y)           noexcept { return x.view() _Op y; }        \
+  friend bool operator _Op (view_type x, const basic_string &y)           noexcept { return x _Op y.view(); }        \
+  friend bool operator _Op (const basic_string &x, const CharT *y)        noexcept { return x.view() _Op view_type(y); } \
+  friend bool operator _Op (const CharT *x, const basic_string &y)        noexcept { return view_type(x) _Op y.view(); }
+
+  IMPL_OPERATOR(==)
+  IMPL_OPERATOR(!=)
+  IMPL_OPERATOR(<)
+  IMPL_OPERATOR(>)
+  IMPL_OPERATOR(<=)
+  IMPL_OPERATOR(>=)
+
+#undef IMPL_OPERATOR
+
+  friend basic_string operator+ (const basic_string &x, view_type y) {
+    basic_string out(x.get_allocator());
+    out.reserve(x.size() + y.size());
+    out.append(x.view()).append(y);
+    return out;
+  }
+  friend basic_string operator+ (basic_string &&x, view_type y) { return std::move(x.append(y)); }
+
+private:
+  // The tag is the last byte of the object. Heap strings mark it with a bit
+  // of their capacity word: the top one on little-endian targets, the
+  // bottom one on big-endian ones, where inline tags are shifted past it.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  static constexpr unsigned char heap_bit  = 0x01;
+  static constexpr unsigned      tag_shift = 1;
+
+  static constexpr size_type encode_cap (size_type cap) noexcept { return (cap << 1) | 1; }
+  static constexpr size_type decode_cap (size_type cap) noexcept { return cap >> 1; }
+#else
+  static constexpr unsigned char heap_bit  = 0x80;
+  static constexpr unsigned      tag_shift = 0;
+  static constexpr size_type     cap_flag  = size_type(1) << (std::numeric_limits<size_type>::digits - 1);
+
+  static constexpr size_type encode_cap (size_type cap) noexcept { return cap | cap_flag; }
+  static constexpr size_type decode_cap (size_type cap) noexcept { return cap & ~cap_flag; }
+#endif
+
+  static_assert(rep_bytes % sizeof(CharT) == 0, "characters tile the representation");
+  static_assert((inline_capacity << tag_shift) <= 0xFF && ((inline_capacity << tag_shift) & heap_bit) == 0,
+                "inline tags fit the tag byte and stay clear of the heap bit");
+
+  union rep_t {
+    heap_t        heap;
+    CharT         buf[inline_capacity + 1];
+    unsigned char raw[rep_bytes];
+  };
+
+  /// Allocator as an empty base, so std::allocator costs nothing.
+  struct impl_t : Alloc {
+    impl_t (void) = default;
+    impl_t (const Alloc &a) : Alloc(a) { }
+    impl_t (Alloc &&a) : Alloc(std::move(a)) { }
+
+    rep_t rep;
+  };
+
+  Alloc       &alloc (void)       noexcept { return _impl; }
+  const Alloc &alloc (void) const noexcept { return _impl; }
+
+  unsigned char tag (void) const noexcept { return _impl.rep.raw[rep_bytes - 1]; }
+
+  CharT       *ptr (void)       noexcept { return is_inline() ? _impl.rep.buf : _impl.rep.heap.data; }
+  const CharT *ptr (void) const noexcept { return is_inline() ? _impl.rep.buf : _impl.rep.heap.data; }
+
+  /// Terminates first: at full capacity the tag byte then overwrites
+  /// the terminator with zero, which it already is.
+  void set_inline_size (size_type n) noexcept {
+    _impl.rep.buf[n] = CharT();
+    _impl.rep.raw[rep_bytes - 1] = static_cast<unsigned char>((inline_capacity - n) << tag_shift);
+  }
+
+  void set_size (size_type n) noexcept {
+    if (is_inline()) {
+      set_inline_size(n);
+    } else {
+      _impl.rep.heap.size = n;
+      _impl.rep.heap.data[n] = CharT();
+    }
+  }
+
+  void init (const CharT *s, size_type n) {
+    if (n <= inline_capacity) {
+      Traits::copy(_impl.rep.buf, s, n);
+      set_inline_size(n);
+      return;
+    }
+    CharT *p = allocate(n);
+    Traits::copy(p, s, n);
+    p[n] = CharT();
+    _impl.rep.heap = { p, n, encode_cap(n) };
+  }
+
+  void steal (basic_string &o) noexcept {
+    std::memcpy(&_impl.rep, &o._impl.rep, rep_bytes);
+    o.set_inline_size(0);
+  }
+
+  /// @brief Room for @p cap characters and the terminator.
+  CharT *allocate (size_type cap) {
+    if (cap > max_size()) { throw std::length_error("omtl::str::basic_string"); }
+    return alloc_traits::allocate(alloc(), cap + 1);
+  }
+
+  /// @brief Switches to the heap buffer @p p, holding @p n characters,
+  ///        after releasing the current one.
+  void adopt (CharT *p, size_type n, size_type cap) noexcept {
+    release();
+    p[n] = CharT();
+    _impl.rep.heap = { p, n, encode_cap(cap) };
+  }
+
+  void release (void) noexcept {
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc(), _impl.rep.heap.data, decode_cap(_impl.rep.heap.cap) + 1);
+    }
+  }
+
+  size_type grown_capacity (size_type n) const noexcept { return std::max(n, std::min(2 * capacity(), max_size())); }
+
+  void validate (size_type index) const {
+    if (index >= size()) {
+      throw std::out_of_range("omtl::str::basic_string");
+    }
+  }
+
+  impl_t _impl;
+};
+
+
+template <class CharT, class Traits, class Alloc>
+void swap (basic_string<CharT, Traits, Alloc> &a, basic_string<CharT, Traits, Alloc> &b) noexcept { a.swap(b); }
+
+
+using string    = basic_string<char>;
+using wstring   = basic_string<wchar_t>;
+using u16string = basic_string<char16_t>;
+using u32string = basic_string<char32_t>;
+
+
+}  // namespace str
+}  // namespace omtl
+
+
+namespace std {
+
+template <class CharT, class Traits, class Alloc>
+struct hash<omtl::str::basic_string<CharT, Traits, Alloc>> {
+  size_t operator() (const omtl::str::basic_string<CharT, Traits, Alloc> &s) const noexcept {
+    return static_cast<size_t>(omtl::str::hash_of(s.view()));
+  }
+};
+
+}  // namespace std
+
+
+#endif  // OMTL_STR_STRING_H
@@ -0,0 +1,580 @@
+#pragma once
+
+#ifndef OMTL_STR_UTF8_H
+#define OMTL_STR_UTF8_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <omtl/utils/bits.h>
+#include <omtl/utils/cpu.h>
+#include <omtl/str/view.h>
+
+
+namespace omtl {
+namespace str {
+namespace utf8 {
+
+
+constexpr char32_t replacement = 0xFFFD;
+constexpr size_t   npos        = size_t(-1);
+
+
+/// @struct One decoded code point and the bytes it took. An ill-formed
+///         sequence decodes to U+FFFD and consumes its maximal subpart, as
+///         the Unicode standard recommends, so decoding always advances.
+struct decoded {
+  char32_t code_point;
+  uint32_t length;
+  bool     valid;
+};
+
+
+/// @brief Decodes the sequence at @p s, @p n > 0 bytes long. The checks
+///        follow table 3-7 of the standard, which rules out overlongs,
+///        surrogates and values past U+10FFFF.
+constexpr decoded decode (const char *s, size_t n) noexcept {
+  const uint8_t b0 = static_cast<uint8_t>(s[0]);
+  if (b0 < 0x80) { return { b0, 1, true }; }
+
+  // Second-byte bounds depend on the lead; later bytes are 0x80..0xBF.
+  const uint8_t b1 = n > 1 ? static_cast<uint8_t>(s[1]) : 0;
+  if (b0 >= 0xC2 && b0 <= 0xDF) {
+    if (b1 < 0x80 || b1 > 0xBF) { return { replacement, 1, false }; }
+    return { (char32_t(b0 & 0x1F) << 6) | (b1 & 0x3F), 2, true };
+  }
+
+  uint8_t lo = 0x80, hi = 0xBF;
+  if (b0 >= 0xE0 && b0 <= 0xEF) {
+    lo = b0 == 0xE0 ? 0xA0 : 0x80;
+    hi = b0 == 0xED ? 0x9F : 0xBF;
+    if (b1 < lo || b1 > hi) { return { replacement, 1, false }; }
+    const uint8_t b2 = n > 2 ? static_cast<uint8_t>(s[2]) : 0;
+    if (b2 < 0x80 || b2 > 0xBF) { return { replacement, 2, false }; }
+    return { (char32_t(b0 & 0x0F) << 12) | (char32_t(b1 & 0x3F) << 6) | (b2 & 0x3F), 3, true };
+  }
+
+  if (b0 >= 0xF0 && b0 <= 0xF4) {
+    lo = b0 == 0xF0 ? 0x90 : 0x80;
+    hi = b0 == 0xF4 ? 0x8F : 0xBF;
+    if (b1 < lo || b1 > hi) { return { replacement, 1, false }; }
+    const uint8_t b2 = n > 2 ? static_cast<uint8_t>(s[2]) : 0;
+    if (b2 < 0x80 || b2 > 0xBF) { return { replacement, 2, false }; }
+    const uint8_t b3 = n > 3 ? static_cast<uint8_t>(s[3]) : 0;
+    if (b3 < 0x80 || b3 > 0xBF) { return { replacement, 3, false }; }
+    return { (char32_t(b0 & 0x07) << 18) | (char32_t(b1 & 0x3F) << 12) | (char32_t(b2 & 0x3F) << 6) | (b3 & 0x3F), 4, true };
+  }
+  return { replacement, 1, false };
+}
+
+/// @brief Writes @p cp to @p out as 1 to 4 bytes and returns the count.
+///        Surrogates and values past U+10FFFF are written as U+FFFD.
+constexpr size_t encode (char32_t cp, char *out) noexcept {
+  if (cp < 0x80) { out[0] = static_cast<char>(cp); return 1; }
+  if (cp < 0x800) {
+    out[0] = static_cast<char>(0xC0 | (cp >> 6));
+    out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) { cp = replacement; }
+  if (cp < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | (cp >> 12));
+    out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | (cp >> 18));
+  out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+
+namespace detail {
+
+
+constexpr bool is_continuation (char c) noexcept { return (static_cast<uint8_t>(c) & 0xC0) == 0x80; }
+
+constexpr size_t find_invalid_scalar (const char *s, size_t n) noexcept {
+  size_t i = 0;
+  while (i < n) {
+    if (static_cast<uint8_t>(s[i]) < 0x80) { ++i; continue; }
+    const decoded d = decode(s + i, n - i);
+    if (!d.valid) { return i; }
+    i += d.length;
+  }
+  return npos;
+}
+
+/// Lead bytes, plus one more per 4-byte lead when @p surrogates is set:
+/// the code points, or the UTF-16 units, of valid input.
+constexpr size_t count_scalar (const char *s, size_t n, bool surrogates) noexcept {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += !is_continuation(s[i]);
+    count += surrogates && static_cast<uint8_t>(s[i]) >= 0xF0;
+  }
+  return count;
+}
+
+
+#ifdef OMTL_SIMD_X86
+
+/// Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per
+/// Byte": three nibble lookups, on the high and low nibble of the previous
+/// byte and the high nibble of the current one, flag every error that two
+/// bytes can show; and'ed together, they leave one bit per error kind.
+/// The rest needs more context: a continuation following a continuation
+/// (two_conts, the 0x80 bit) is only right where the byte two or three
+/// back is a 3- or 4-byte lead, so that bit must match those leads
+/// exactly. Blocks of pure ASCII only need to check that the previous
+/// block did not end inside a sequence.
+enum : uint8_t {
+  too_short  = 1 << 0,
+  too_long   = 1 << 1,
+  overlong_3 = 1 << 2,
+  too_large  = 1 << 3,
+  surrogate  = 1 << 4,
+  overlong_2 = 1 << 5,
+  too_large_1000 = 1 << 6,
+  overlong_4 = 1 << 6,
+  two_conts  = 1 << 7,
+  carry      = too_short | too_long | two_conts,
+};
+
+/// The three nibble lookups, loaded whole into the shuffle tables.
+alignas(16) constexpr uint8_t byte_1_high[16] = {
+  too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+  two_conts, two_conts, two_conts, two_conts,
+  too_short | overlong_2,
+  too_short,
+  too_short | overlong_3 | surrogate,
+  too_short | too_large | too_large_1000 | overlong_4
+};
+
+alignas(16) constexpr uint8_t byte_1_low[16] = {
+  carry | overlong_3 | overlong_2 | overlong_4,
+  carry | overlong_2,
+  carry, carry,
+  carry | too_large,
+  carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+  carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+  carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+  carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+  carry | too_large | too_large_1000 | surrogate,
+  carry | too_large | too_large_1000, carry | too_large | too_large_1000
+};
+
+alignas(16) constexpr uint8_t byte_2_high[16] = {
+  too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+  too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+  too_long | overlong_2 | two_conts | overlong_3 | too_large,
+  too_long | overlong_2 | two_conts | surrogate  | too_large,
+  too_long | overlong_2 | two_conts | surrogate  | too_large,
+  too_short, too_short, too_short, too_short
+};
+
+/// Bytes past these in the last three positions of a block start a
+/// sequence that needs the next block; the last _Width bytes are loaded.
+alignas(32) constexpr uint8_t incomplete_at[32] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+/// _Prev(cur, prev, N): the block shifted back by N bytes, the first N
+/// taken from the end of the previous block.
+#define OMTL_UTF8_PREV_SSSE3(_Cur, _Prev, _N) _mm_alignr_epi8(_Cur, _Prev, 16 - (_N))
+#define OMTL_UTF8_PREV_AVX2(_Cur, _Prev, _N) \
+  _mm256_alignr_epi8(_Cur, _mm256_permute2x128_si256(_Prev, _Cur, 0x21), 16 - (_N))
+
+#define OMTL_UTF8_TABLE_SSSE3(_T) _mm_load_si128(reinterpret_cast<const __m128i *>(_T))
+#define OMTL_UTF8_TABLE_AVX2(_T)  _mm256_broadcastsi128_si256(OMTL_UTF8_TABLE_SSSE3(_T))
+
+#define OMTL_IMPL_UTF8_SIMD(_Name, _Isa, _Vec, _Width, _Set1, _Table, _Load, _And, _Or, _Xor, _Srli,  \
+                            _Shuffle, _Subs, _Cmpeq, _Cmpgt, _Zero, _Mask, _Prev)                     \
+OMTL_TARGET(_Isa)                                                                                     \
+inline _Vec _Name##_check (_Vec input, _Vec prev_input) noexcept {                                    \
+  const _Vec nib   = _Set1(0x0F);                                                                     \
+  const _Vec prev1 = _Prev(input, prev_input, 1);                                                     \
+  const _Vec b1h = _Shuffle(_Table(byte_1_high), _And(_Srli(prev1, 4), nib));               \
+  const _Vec b1l = _Shuffle(_Table(byte_1_low), _And(prev1, nib));                          \
+  const _Vec b2h = _Shuffle(_Table(byte_2_high), _And(_Srli(input, 4), nib));               \
+  const _Vec special = _And(_And(b1h, b1l), b2h);                                                     \
+  const _Vec third   = _Subs(_Prev(input, prev_input, 2), _Set1(char(0xE0 - 0x80)));                  \
+  const _Vec fourth  = _Subs(_Prev(input, prev_input, 3), _Set1(char(0xF0 - 0x80)));                  \
+  return _Xor(_And(_Or(third, fourth), _Set1(char(0x80))), special);                                  \
+}                                                                                                     \
+                                                                                                      \
+OMTL_TARGET(_Isa)                                                                                     \
+inline bool _Name##_any (_Vec error) noexcept {                                                       \
+  return static_cast<uint32_t>(_Mask(_Cmpeq(error, _Zero()))) != static_cast<uint32_t>((uint64_t(1) << _Width) - 1); \
+}                                                                                                     \
+                                                                                                      \
+/* Offset of the first block with an error, or npos. The tail is padded  */                          \
+/* with ASCII zeros, which also reject a sequence cut off at the end.     */                          \
+OMTL_TARGET(_Isa)                                                                                     \
+inline size_t _Name##_find_invalid_block (const char *s, size_t n) noexcept {                         \
+  const _Vec incomplete = _Load(reinterpret_cast<const _Vec *>(incomplete_at + 32 - _Width));         \
+  _Vec prev_input = _Zero(), prev_incomplete = _Zero();                                               \
+  size_t i = 0;                                                                                       \
+  for (; i + _Width <= n; i += _Width) {                                                              \
+    const _Vec input = _Load(reinterpret_cast<const _Vec *>(s + i));                                  \
+    _Vec error;                                                                                       \
+    if (_Mask(input) == 0) {                                                                          \
+      error = prev_incomplete;                                                                        \
+      prev_incomplete = _Zero();                                                                      \
+    } else {                                                                                          \
+      error = _Name##_check(input, prev_input);                                                       \
+      prev_incomplete = _Subs(input, incomplete);                                                     \
+    }                                                                                                 \
+    if (_Name##_any(error)) { return i; }                                                             \
+    prev_input = input;                                                                               \
+  }                                                                                                   \
+  char tail[_Width] = { };                                                                            \
+  std::memcpy(tail, s + i, n - i);                                                                    \
+  return _Name##_any(_Name##_check(_Load(reinterpret_cast<const _Vec *>(tail)), prev_input)) ? i : npos; \
+}                                                                                                     \
+                                                                                                      \
+/* Lead bytes are those above 0xBF as signed values; 4-byte leads are    */                          \
+/* those past 0xEF unsigned, i.e. left nonzero by a saturating subtract.  */                          \
+OMTL_TARGET(_Isa)                                                                                     \
+inline size_t _Name##_count (const char *s, size_t n, bool surrogates) noexcept {                     \
+  const _Vec last_cont = _Set1(char(0xBF));                                                           \
+  const _Vec last_3    = _Set1(char(0xEF));                                                           \
+  const unsigned width = _Width;                                                                      \
+  size_t count = 0, i = 0;                                                                            \
+  for (; i + _Width <= n; i += _Width) {                                                              \
+    const _Vec input = _Load(reinterpret_cast<const _Vec *>(s + i));                                  \
+    count += bits::popcount64(static_cast<uint32_t>(_Mask(_Cmpgt(input, last_cont))));                \
+    if (surrogates) {                                                                                 \
+      count += width - bits::popcount64(static_cast<uint32_t>(_Mask(_Cmpeq(_Subs(input, last_3), _Zero())))); \
+    }                                                                                                 \
+  }                                                                                                   \
+  return count + count_scalar(s + i, n - i, surrogates);                                              \
+}
+
+OMTL_IMPL_UTF8_SIMD(utf8_ssse3, "ssse3", __m128i, 16, _mm_set1_epi8, OMTL_UTF8_TABLE_SSSE3, _mm_loadu_si128,
+                    _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_srli_epi16, _mm_shuffle_epi8,
+                    _mm_subs_epu8, _mm_cmpeq_epi8, _mm_cmpgt_epi8, _mm_setzero_si128, _mm_movemask_epi8,
+                    OMTL_UTF8_PREV_SSSE3)
+OMTL_IMPL_UTF8_SIMD(utf8_avx2, "avx2", __m256i, 32, _mm256_set1_epi8, OMTL_UTF8_TABLE_AVX2, _mm256_loadu_si256,
+                    _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_srli_epi16, _mm256_shuffle_epi8,
+                    _mm256_subs_epu8, _mm256_cmpeq_epi8, _mm256_cmpgt_epi8, _mm256_setzero_si256, _mm256_movemask_epi8,
+                    OMTL_UTF8_PREV_AVX2)
+
+#undef OMTL_IMPL_UTF8_SIMD
+#undef OMTL_UTF8_TABLE_AVX2
+#undef OMTL_UTF8_TABLE_SSSE3
+#undef OMTL_UTF8_PREV_AVX2
+#undef OMTL_UTF8_PREV_SSSE3
+
+
+/// Transcoding runs of ASCII, which are most of the text in practice:
+/// 16 bytes are widened, or 16 units narrowed, per step with SSE2. In a
+/// block holding anything else, the ASCII prefix is copied and the scalar
+/// code decodes the run of non-ASCII sequences that follows.
+inline uint32_t ascii_mask (const char *s) noexcept {
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s))));
+}
+
+inline void widen_ascii (const char *s, char16_t *out) noexcept {
+  const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),     _mm_unpacklo_epi8(in, _mm_setzero_si128()));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpackhi_epi8(in, _mm_setzero_si128()));
+}
+
+inline void widen_ascii (const char *s, char32_t *out) noexcept {
+  const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+  const __m128i lo = _mm_unpacklo_epi8(in, _mm_setzero_si128());
+  const __m128i hi = _mm_unpackhi_epi8(in, _mm_setzero_si128());
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),      _mm_unpacklo_epi16(lo, _mm_setzero_si128()));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4),  _mm_unpackhi_epi16(lo, _mm_setzero_si128()));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8),  _mm_unpacklo_epi16(hi, _mm_setzero_si128()));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(hi, _mm_setzero_si128()));
+}
+
+inline bool narrow_ascii (const char16_t *s, char *out) noexcept {
+  const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+  const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 8));
+  const __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(short(0xFF80)));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) != 0xFFFF) { return false; }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(a, b));
+  return true;
+}
+
+inline bool narrow_ascii (const char32_t *s, char *out) noexcept {
+  const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+  const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 4));
+  const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 8));
+  const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 12));
+  const __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32(~0x7F));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) != 0xFFFF) { return false; }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  return true;
+}
+
+#endif  // OMTL_SIMD_X86
+
+
+inline size_t find_invalid (const char *s, size_t n) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::ssse3)) {
+    size_t block = cpu::supports(cpu::feature::avx2) ? utf8_avx2_find_invalid_block(s, n)
+                                                     : utf8_ssse3_find_invalid_block(s, n);
+    if (block == npos) { return npos; }
+    // The error lies in the block or in a sequence cut by its start, so
+    // rescan from the first code point starting in the 3 bytes before it.
+    const size_t end = block;
+    block = block >= 3 ? block - 3 : 0;
+    while (block < end && is_continuation(s[block])) { ++block; }
+    const size_t found = find_invalid_scalar(s + block, n - block);
+    return found == npos ? npos : block + found;
+  }
+#endif
+  return find_invalid_scalar(s, n);
+}
+
+inline size_t count (const char *s, size_t n, bool surrogates) noexcept {
+#ifdef OMTL_SIMD_X86
+  if (cpu::supports(cpu::feature::avx2))  { return utf8_avx2_count(s, n, surrogates); }
+  if (cpu::supports(cpu::feature::ssse3)) { return utf8_ssse3_count(s, n, surrogates); }
+#endif
+  return count_scalar(s, n, surrogates);
+}
+
+
+/// Widens UTF-8 into UTF-16 or UTF-32 units, U+FFFD for ill-formed input.
+template <class UnitT>
+size_t transcode (const char *s, size_t n, UnitT *out) noexcept {
+  UnitT *const start = out;
+  size_t i = 0;
+  while (i < n) {
+    size_t stop = n;
+#ifdef OMTL_SIMD_X86
+    if (i + 16 <= n) {
+      const uint32_t high = ascii_mask(s + i);
+      if (high == 0) {
+        widen_ascii(s + i, out);
+        i += 16; out += 16;
+        continue;
+      }
+      // Copy the ASCII prefix, then decode up to the next ASCII byte.
+      for (const size_t ascii = i + bits::ctz(high); i < ascii; ++i) { *out++ = static_cast<UnitT>(s[i]); }
+      stop = i + 16;
+    }
+#endif
+    while (i < stop && (static_cast<uint8_t>(s[i]) >= 0x80 || stop == n)) {
+      const decoded d = decode(s + i, n - i);
+      i += d.length;
+      if (sizeof(UnitT) == 2 && d.code_point >= 0x10000) {
+        *out++ = static_cast<UnitT>(0xD800 + ((d.code_point - 0x10000) >> 10));
+        *out++ = static_cast<UnitT>(0xDC00 + ((d.code_point - 0x10000) & 0x3FF));
+      } else {
+        *out++ = static_cast<UnitT>(d.code_point);
+      }
+    }
+  }
+  return static_cast<size_t>(out - start);
+}
+
+/// Narrows UTF-16 or UTF-32 into UTF-8; unpaired surrogates and values
+/// past U+10FFFF become U+FFFD.
+template <class UnitT>
+size_t transcode (const UnitT *s, size_t n, char *out) noexcept {
+  char *const start = out;
+  size_t i = 0;
+  while (i < n) {
+#ifdef OMTL_SIMD_X86
+    if (i + 16 <= n && narrow_ascii(s + i, out)) {
+      i += 16; out += 16;
+      continue;
+    }
+#endif
+    for (const size_t stop = std::min(n, i + 16); i < stop; ++i) {
+      char32_t cp = static_cast<char32_t>(s[i]);
+      if (sizeof(UnitT) == 2 && cp >= 0xD800 && cp <= 0xDBFF && i + 1 < n &&
+          s[i + 1] >= 0xDC00 && s[i + 1] <= 0xDFFF) {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<char32_t>(s[i + 1]) - 0xDC00);
+        ++i;
+      }
+      out += encode(cp, out);
+    }
+  }
+  return static_cast<size_t>(out - start);
+}
+
+
+}  // namespace detail
+
+
+/// @brief Offset of the first byte of the first ill-formed sequence in
+///        @p str, or npos. With SSSE3 or AVX2 the input is checked 16 or 32
+///        bytes per step and only the failing block is rescanned.
+template <class Traits>
+constexpr size_t find_invalid (basic_view<char, Traits> str) noexcept {
+  if (cpu::constant_evaluated()) { return detail::find_invalid_scalar(str.data(), str.size()); }
+  return detail::find_invalid(str.data(), str.size());
+}
+
+template <class Traits>
+constexpr bool valid (basic_view<char, Traits> str) noexcept {
+  return find_invalid(str) == npos;
+}
+
+/// @brief Code points in valid UTF-8, i.e. the bytes that are not
+///        continuations. On ill-formed input the count is meaningless.
+template <class Traits>
+constexpr size_t length (basic_view<char, Traits> str) noexcept {
+  if (cpu::constant_evaluated()) { return detail::count_scalar(str.data(), str.size(), false); }
+  return detail::count(str.data(), str.size(), false);
+}
+
+/// @brief UTF-16 units needed for valid UTF-8: code points plus one per
+///        4-byte sequence.
+template <class Traits>
+constexpr size_t utf16_length (basic_view<char, Traits> str) noexcept {
+  if (cpu::constant_evaluated()) { return detail::count_scalar(str.data(), str.size(), true); }
+  return detail::count(str.data(), str.size(), true);
+}
+
+
+/// @brief Writes @p str as UTF-16 to @p out and returns the units written,
+///        at most str.size(). Ill-formed sequences become U+FFFD; check
+///        valid() first to reject them instead.
+template <class Traits>
+size_t to_utf16 (basic_view<char, Traits> str, char16_t *out) noexcept {
+  return detail::transcode(str.data(), str.size(), out);
+}
+
+/// @brief As to_utf16(), as UTF-32, at most str.size() units.
+template <class Traits>
+size_t to_utf32 (basic_view<char, Traits> str, char32_t *out) noexcept {
+  return detail::transcode(str.data(), str.size(), out);
+}
+
+/// @brief Writes UTF-16 @p str as UTF-8 to @p out and returns the bytes
+///        written, at most 3 * str.size(). Unpaired surrogates become U+FFFD.
+template <class Traits>
+size_t from_utf16 (basic_view<char16_t, Traits> str, char *out) noexcept {
+  return detail::transcode(str.data(), str.size(), out);
+}
+
+/// @brief As from_utf16(), from UTF-32, at most 4 * str.size() bytes.
+template <class Traits>
+size_t from_utf32 (basic_view<char32_t, Traits> str, char *out) noexcept {
+  return detail::transcode(str.data(), str.size(), out);
+}
+
+
+/// @brief The transcoded text in a new string of type @p String, e.g.
+///        std::u16string or str::u16string: sized for the worst case once,
+///        then shrunk to what was written.
+template <class String = std::u16string, class Traits>
+String to_utf16 (basic_view<char, Traits> str) {
+  String out;
+  out.resize(str.size());
+  out.resize(to_utf16(str, &out[0]));
+  return out;
+}
+
+template <class String = std::u32string, class Traits>
+String to_utf32 (basic_view<char, Traits> str) {
+  String out;
+  out.resize(str.size());
+  out.resize(to_utf32(str, &out[0]));
+  return out;
+}
+
+template <class String = std::string, class Traits>
+String from_utf16 (basic_view<char16_t, Traits> str) {
+  String out;
+  out.resize(3 * str.size());
+  out.resize(from_utf16(str, &out[0]));
+  return out;
+}
+
+template <class String = std::string, class Traits>
+String from_utf32 (basic_view<char32_t, Traits> str) {
+  String out;
+  out.resize(4 * str.size());
+  out.resize(from_utf32(str, &out[0]));
+  return out;
+}
+
+
+/// @class Forward range of the code points of a UTF-8 view, decoded on
+///        the fly. Ill-formed sequences yield U+FFFD once per maximal
+///        subpart; position() gives the byte offset of the current one.
+template <class Traits = std::char_traits<char>>
+class code_point_range {
+public:
+  using view_type = basic_view<char, Traits>;
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = char32_t;
+    using difference_type   = ptrdiff_t;
+    using pointer           = const char32_t *;
+    using reference         = char32_t;
+
+    constexpr iterator (void) noexcept = default;
+
+    constexpr char32_t operator * (void) const noexcept { return _cur.code_point; }
+
+    /// @brief Whether the current code point was well-formed.
+    constexpr bool   valid    (void) const noexcept { return _cur.valid; }
+    constexpr size_t position (void) const noexcept { return static_cast<size_t>(_pos - _begin); }
+    /// @brief The bytes of the current code point.
+    constexpr view_type bytes (void) const noexcept { return view_type(_pos, _cur.length); }
+
+    constexpr iterator &operator ++ (void) noexcept { _pos += _cur.length; load(); return *this; }
+    constexpr iterator  operator ++ (int)  noexcept { iterator cp(*this); ++*this; return cp; }
+
+    constexpr bool operator == (const iterator &o) const noexcept { return _pos == o._pos; }
+    constexpr bool operator != (const iterator &o) const noexcept { return _pos != o._pos; }
+
+  private:
+    friend class code_point_range;
+
+    constexpr iterator (const char *begin, const char *pos, const char *end) noexcept
+      : _begin(begin), _pos(pos), _end(end) { load(); }
+
+    constexpr void load (void) noexcept {
+      if (_pos != _end) { _cur = decode(_pos, static_cast<size_t>(_end - _pos)); }
+    }
+
+    const char *_begin = nullptr;
+    const char *_pos   = nullptr;
+    const char *_end   = nullptr;
+    decoded     _cur   = { 0, 0, false };
+  };
+
+  constexpr explicit code_point_range (view_type str) noexcept : _str(str) { }
+
+  constexpr iterator begin (void) const noexcept { return iterator(_str.data(), _str.data(), _str.data() + _str.size()); }
+  constexpr iterator end   (void) const noexcept {
+    return iterator(_str.data(), _str.data() + _str.size(), _str.data() + _str.size());
+  }
+
+private:
+  view_type _str;
+};
+
+/// @brief for (char32_t cp : utf8::code_points(text)) ...
+template <class Traits>
+constexpr code_point_range<Traits> code_points (basic_view<char, Traits> str) noexcept {
+  return code_point_range<Traits>(str);
+}
+}  // namespace utf8
+}  // namespace str
+}  // namespace omtl
+
+
+#endif  // OMTL_STR_UTF8_H
@@ -31,6 +31,16 @@ using u32view = basic_view<char32_t>;
 #else  // OMTL_CXX17_SUPPORT
 
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+#include <omtl/utils/cpu.h>
+#include <omtl/str/charset.h>
+#include <omtl/str/search.h>
+
+
 namespace omtl {
 namespace str {
 
@@ -47,7 +57,7 @@ public:
   using       reference =       CharT&;
   using const_reference = const CharT&;
 
-  using iterator       = pointer;
+  using iterator       = const_pointer;
   using const_iterator = const_pointer;
   using reverse_iterator       = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
@@ -67,15 +77,15 @@ public:
   constexpr basic_view (const CharT *str, size_type len)
     : _data(str), _size(len) { }
 
-  iterator         begin  (void) const noexcept { return _data; }
-  iterator         end    (void) const noexcept { return _data + _size; }
-  reverse_iterator rbegin (void) const noexcept { return _data + _size; }
-  reverse_iterator rend   (void) const noexcept { return _data; }
+  constexpr iterator         begin  (void) const noexcept { return _data; }
+  constexpr iterator         end    (void) const noexcept { return _data + _size; }
+  constexpr reverse_iterator rbegin (void) const noexcept { return reverse_iterator(end()); }
+  constexpr reverse_iterator rend   (void) const noexcept { return reverse_iterator(begin()); }
 
-  constexpr const_iterator cbegin  (void) const noexcept { return _data; }
-  constexpr const_iterator cend    (void) const noexcept { return _data + _size; }
-  const_reverse_iterator   crbegin (void) const noexcept { return _data + _size; }
-  const_reverse_iterator   crend   (void) const noexcept { return _data; }
+  constexpr const_iterator         cbegin  (void) const noexcept { return _data; }
+  constexpr const_iterator         cend    (void) const noexcept { return _data + _size; }
+  constexpr const_reverse_iterator crbegin (void) const noexcept { return const_reverse_iterator(cend()); }
+  constexpr const_reverse_iterator crend   (void) const noexcept { return const_reverse_iterator(cbegin()); }
 
   constexpr size_type size     (void) const noexcept { return _size;}
   constexpr size_type length   (void) const noexcept { return _size; }
@@ -89,7 +99,7 @@ public:
   constexpr const_reference back  (void) const { validate(0); return _data[_size - 1]; }
   constexpr const_pointer   data  (void) const noexcept { return _data; }
 
-  constexpr void remove_prefix (size_type n) { _data += n; }
+  constexpr void remove_prefix (size_type n) { _data += n; _size -= n; }
   constexpr void remove_suffix (size_type n) { _size -= n; }
 
   constexpr void swap (basic_view &s) noexcept {
@@ -98,180 +108,207 @@ public:
   }
 
   size_type copy (CharT *s, size_type n, size_type pos = 0) const {
-    validate(pos)
+    validate(pos);
     size_type copied = std::min(n, size() - pos);
     Traits::copy(s, _data + pos, copied);
     return copied;
   }
 
-  basic_view substr (size_type pos = 0, size_type n = npos) const {
-    validate(pos)
+  constexpr basic_view substr (size_type pos = 0, size_type n = npos) const {
+    validate(pos);
     size_type copied = std::min(n, size() - pos);
     return basic_view(_data + pos, copied);
   }
 
-  int compare (basic_view s) const noexcept {
-    int traitsComp = Traits::compare(_data, s.data, std::min(size(), s.size()));
+  constexpr int compare (basic_view s) const noexcept {
+    int traitsComp = Traits::compare(_data, s.data(), std::min(size(), s.size()));
     return traitsComp ? traitsComp : ((int)size() - (int)s.size());
   }
 
-  int compare(size_type pos1, size_type n1, basic_view s) const {
+  constexpr int compare (size_type pos1, size_type n1, basic_view s) const {
     return substr(pos1, n1).compare(s);
   }
 
-  int compare (size_type pos1, size_type n1, basic_view s, size_type pos2, size_type n2) const {
+  constexpr int compare (size_type pos1, size_type n1, basic_view s, size_type pos2, size_type n2) const {
     return substr(pos1, n1).compare(s.substr(pos2, n2));
   }
 
-  int compare (const CharT* s) const {
+  constexpr int compare (const CharT* s) const {
     return compare(basic_view(s));
   }
 
-  int compare (size_type pos1, size_type n1, const CharT* s) const {
+  constexpr int compare (size_type pos1, size_type n1, const CharT* s) const {
     return substr(pos1, n1).compare(basic_view(s));
   }
 
-  int compare (size_type pos1, size_type n1, const CharT* s, size_type n2) const {
+  constexpr int compare (size_type pos1, size_type n1, const CharT* s, size_type n2) const {
     return substr(pos1, n1).compare(basic_view(s, n2));
   }
 
 
-  size_type find (basic_view s, size_type pos = 0) const noexcept {
-    for (size_type i = pos; i < length() - s.length(); ++i) {
-      if (Traits::compare(data() + i, s.data(), s.length()) == 0) {
-        return i;
-      }
-    }
-    return npos;
+  constexpr size_type find (basic_view s, size_type pos = 0) const noexcept {
+    if (pos > size()) { return npos; }
+    size_type found = detail::search<CharT, Traits>(_data + pos, size() - pos, s.data(), s.size());
+    return found == npos ? npos : pos + found;
   }
 
-  size_type find (CharT c, size_type pos = npos) const noexcept {
-    return find(basic_view(&c, 1), pos);
+  constexpr size_type find (CharT c, size_type pos = 0) const noexcept {
+    if (pos >= size()) { return npos; }
+    const_pointer found = Traits::find(_data + pos, size() - pos, c);
+    return found ? static_cast<size_type>(found - _data) : npos;
   }
 
-  size_type find (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type find (const CharT *s, size_type pos, size_type n) const {
     return find(basic_view(s, n), pos);
   }
 
-  size_type find (const CharT *s, size_type pos = npos) const {
+  constexpr size_type find (const CharT *s, size_type pos = 0) const {
     return find(basic_view(s), pos);
   }
 
 
-  size_type rfind (basic_view s, size_type pos = npos) const noexcept {
-    pos = std::min(pos, length());
-    for (size_type i = pos - s.length(); i >= 0 ; --i) {
-      if (Traits::compare(data() + i, s.data(), s.length()) == 0) {
-        return i;
-      }
-    }
-    return npos;
+  constexpr size_type rfind (basic_view s, size_type pos = npos) const noexcept {
+    if (s.size() > size()) { return npos; }
+    size_type last = std::min(pos, size() - s.size());
+    return detail::rsearch<CharT, Traits>(_data, last + s.size(), s.data(), s.size());
   }
 
-  size_type rfind (CharT c, size_type pos = npos) const noexcept {
-    return rfind(basic_view(&c, 1), pos);
+  constexpr size_type rfind (CharT c, size_type pos = npos) const noexcept {
+    if (empty()) { return npos; }
+    return detail::rfind_char<CharT, Traits>(_data, std::min(pos, size() - 1) + 1, c);
   }
 
-  size_type rfind (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type rfind (const CharT *s, size_type pos, size_type n) const {
     return rfind(basic_view(s, n), pos);
   }
 
-  size_type rfind (const CharT *s, size_type pos = npos) const {
+  constexpr size_type rfind (const CharT *s, size_type pos = npos) const {
     return rfind(basic_view(s), pos);
   }
 
 
-  size_type find_first_of (basic_view s, size_type pos = 0) const noexcept {
-    for (size_type i = pos; i < length(); ++i) {
-      if (s.find(at(i)) { return i; }
-    }
-    return npos;
+  constexpr size_type find_first_of (basic_view s, size_type pos = 0) const noexcept {
+    if (s.size() == 1) { return find(s[0], pos); }
+    if (cpu::constant_evaluated()) { return scan_forward(s, pos, false); }
+    return find_first_of(basic_charset<CharT, Traits>(s.data(), s.size()), pos);
   }
 
-  size_type find_first_of (CharT c, size_type pos = npos) const noexcept {
+  size_type find_first_of (const basic_charset<CharT, Traits> &set, size_type pos = 0) const noexcept {
+    if (pos >= size()) { return npos; }
+    size_type found = set.find_first_of(_data + pos, size() - pos);
+    return found == npos ? npos : pos + found;
+  }
+
+  constexpr size_type find_first_of (CharT c, size_type pos = 0) const noexcept {
     return find_first_of(basic_view(&c, 1), pos);
   }
 
-  size_type find_first_of (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type find_first_of (const CharT *s, size_type pos, size_type n) const {
     return find_first_of(basic_view(s, n), pos);
   }
 
-  size_type find_first_of (const CharT *s, size_type pos = npos) const {
+  constexpr size_type find_first_of (const CharT *s, size_type pos = 0) const {
     return find_first_of(basic_view(s), pos);
   }
 
 
-  size_type find_last_of (basic_view s, size_type pos = npos) const noexcept {
-    pos = std::min(pos, length() - 1);
-    for (size_type i = pos; i >= 0; --i) {
-      if (s.find(at(i)) { return i; }
-    }
-    return npos;
+  constexpr size_type find_last_of (basic_view s, size_type pos = npos) const noexcept {
+    if (s.size() == 1) { return rfind(s[0], pos); }
+    if (cpu::constant_evaluated()) { return scan_backward(s, pos, false); }
+    return find_last_of(basic_charset<CharT, Traits>(s.data(), s.size()), pos);
   }
 
-  size_type find_last_of (CharT c, size_type pos = npos) const noexcept {
+  size_type find_last_of (const basic_charset<CharT, Traits> &set, size_type pos = npos) const noexcept {
+    if (empty()) { return npos; }
+    return set.find_last_of(_data, std::min(pos, size() - 1) + 1);
+  }
+
+  constexpr size_type find_last_of (CharT c, size_type pos = npos) const noexcept {
     return find_last_of(basic_view(&c, 1), pos);
   }
 
-  size_type find_last_of (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type find_last_of (const CharT *s, size_type pos, size_type n) const {
     return find_last_of(basic_view(s, n), pos);
   }
 
-  size_type find_last_of (const CharT *s, size_type pos = npos) const {
+  constexpr size_type find_last_of (const CharT *s, size_type pos = npos) const {
     return find_last_of(basic_view(s), pos);
   }
 
 
-  size_type find_first_not_of (basic_view s, size_type pos = 0) const noexcept {
-    for (size_type i = pos; i < length(); ++i) {
-      if (!s.find(at(i)) { return i; }
-    }
-    return npos;
+  constexpr size_type find_first_not_of (basic_view s, size_type pos = 0) const noexcept {
+    if (cpu::constant_evaluated()) { return scan_forward(s, pos, true); }
+    return find_first_not_of(basic_charset<CharT, Traits>(s.data(), s.size()), pos);
   }
 
-  size_type find_first_not_of (CharT c, size_type pos = npos) const noexcept {
+  size_type find_first_not_of (const basic_charset<CharT, Traits> &set, size_type pos = 0) const noexcept {
+    if (pos >= size()) { return npos; }
+    size_type found = set.find_first_not_of(_data + pos, size() - pos);
+    return found == npos ? npos : pos + found;
+  }
+
+  constexpr size_type find_first_not_of (CharT c, size_type pos = 0) const noexcept {
     return find_first_not_of(basic_view(&c, 1), pos);
   }
 
-  size_type find_first_not_of (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type find_first_not_of (const CharT *s, size_type pos, size_type n) const {
     return find_first_not_of(basic_view(s, n), pos);
   }
 
-  size_type find_first_not_of (const CharT *s, size_type pos = npos) const {
+  constexpr size_type find_first_not_of (const CharT *s, size_type pos = 0) const {
     return find_first_not_of(basic_view(s), pos);
   }
 
 
-  size_type find_last_not_of (basic_view s, size_type pos = npos) const noexcept {
-    pos = std::min(pos, length() - 1);
-    for (size_type i = pos; i >= 0; --i) {
-      if (!s.find(at(i)) { return i; }
-    }
-    return npos;
+  constexpr size_type find_last_not_of (basic_view s, size_type pos = npos) const noexcept {
+    if (cpu::constant_evaluated()) { return scan_backward(s, pos, true); }
+    return find_last_not_of(basic_charset<CharT, Traits>(s.data(), s.size()), pos);
   }
 
-  size_type find_last_not_of (CharT c, size_type pos = npos) const noexcept {
+  size_type find_last_not_of (const basic_charset<CharT, Traits> &set, size_type pos = npos) const noexcept {
+    if (empty()) { return npos; }
+    return set.find_last_not_of(_data, std::min(pos, size() - 1) + 1);
+  }
+
+  constexpr size_type find_last_not_of (CharT c, size_type pos = npos) const noexcept {
     return find_last_not_of(basic_view(&c, 1), pos);
   }
 
-  size_type find_last_not_of (const CharT *s, size_type pos, size_type n) const {
+  constexpr size_type find_last_not_of (const CharT *s, size_type pos, size_type n) const {
     return find_last_not_of(basic_view(s, n), pos);
   }
 
-  size_type find_last_not_of (const CharT *s, size_type pos = npos) const {
+  constexpr size_type find_last_not_of (const CharT *s, size_type pos = npos) const {
     return find_last_not_of(basic_view(s), pos);
   }
 
 private:
-  void validate (size_type index) const {
+  constexpr void validate (size_type index) const {
     if (index >= size()) {
-      throw std::out_of_range();
+      throw std::out_of_range("omtl::str::basic_view");
     }
   }
 
+  /// Character-by-character find_*_of for constant evaluation, where
+  /// basic_charset, which owns a heap list, cannot be built.
+  constexpr size_type scan_forward (basic_view set, size_type pos, bool negate) const noexcept {
+    for (size_type i = pos; i < size(); ++i) {
+      if ((Traits::find(set.data(), set.size(), _data[i]) != nullptr) != negate) { return i; }
+    }
+    return npos;
+  }
+
+  constexpr size_type scan_backward (basic_view set, size_type pos, bool negate) const noexcept {
+    if (empty()) { return npos; }
+    for (size_type i = std::min(pos, size() - 1) + 1; i-- > 0;) {
+      if ((Traits::find(set.data(), set.size(), _data[i]) != nullptr) != negate) { return i; }
+    }
+    return npos;
+  }
+
 private:
-  const_pointer _data;
-  size_type     _size;
+  const_pointer _data = nullptr;
+  size_type     _size = 0;
 };
 
 
@@ -282,22 +319,22 @@ using u32string_view = basic_view<char32_t>;
 
 
 template <class CharT, class Traits>
-constexpr bool operator == (basic_view<CharT, Traits> str, nullptr_t) {
+constexpr bool operator == (basic_view<CharT, Traits> str, std::nullptr_t) {
   return str.data() == nullptr;
 }
 
 template <class CharT, class Traits>
-constexpr bool operator == (nullptr_t, basic_view<CharT, Traits> str) {
+constexpr bool operator == (std::nullptr_t, basic_view<CharT, Traits> str) {
   return str.data() == nullptr;
 }
 
 template <class CharT, class Traits>
-constexpr bool operator != (basic_view<CharT, Traits> str, nullptr_t) {
+constexpr bool operator != (basic_view<CharT, Traits> str, std::nullptr_t) {
   return str.data() != nullptr;
 }
 
 template <class CharT, class Traits>
-constexpr bool operator != (nullptr_t, basic_view<CharT, Traits> str) {
+constexpr bool operator != (std::nullptr_t, basic_view<CharT, Traits> str) {
   return str.data() != nullptr;
 }
 
@@ -310,21 +347,34 @@ constexpr bool operator _Op (basic_view<CharT, Traits> x,            \
 
 
 IMPL_OPERATOR(==)
+IMPL_OPERATOR(!=)
 IMPL_OPERATOR(<)
 IMPL_OPERATOR(>)
 IMPL_OPERATOR(<=)
 IMPL_OPERATOR(>=)
 
+#undef IMPL_OPERATOR
+
 
 inline namespace literals {
 inline namespace string_view_literals {
 
 
+// The suffix deliberately mirrors std's; only GCC warns about it.
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wliteral-suffix"
+#endif
+
 constexpr string_view    operator "" sv(const char     *str, size_t len) noexcept { return string_view   (str, len); }
 constexpr wstring_view   operator "" sv(const wchar_t  *str, size_t len) noexcept { return wstring_view  (str, len); }
 constexpr u16string_view operator "" sv(const char16_t *str, size_t len) noexcept { return u16string_view(str, len); }
 constexpr u32string_view operator "" sv(const char32_t *str, size_t len) noexcept { return u32string_view(str, len); }
 
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic pop
+#endif
+
 
 }  // namespace string_view_literals
 }  // namespace literals
@@ -6,7 +6,15 @@
 
 #include <omtl/memory.h>
 #include <omtl/str/view.h>
+#include <omtl/str/string.h>
 #include <omtl/str/storage.h>
+#include <omtl/str/concurrent_storage.h>
+#include <omtl/str/builder.h>
+#include <omtl/str/static_map.h>
+#include <omtl/str/icase.h>
+#include <omtl/str/utf8.h>
+#include <omtl/str/reader.h>
+#include <omtl/str/number.h>
 #include <omtl/str/algorithm.h>
 
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef OMTL_UTILS_BITS_H
+#define OMTL_UTILS_BITS_H
+
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+
+namespace omtl {
+namespace bits {
+
+
+/// @brief Index of the lowest set bit. @p x must not be zero.
+inline unsigned ctz (uint32_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(x));
+#elif defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward(&idx, x);
+  return static_cast<unsigned>(idx);
+#else
+  unsigned n = 0;
+  while (!(x & 1u)) { x >>= 1; ++n; }
+  return n;
+#endif
+}
+
+/// @brief Index of the highest set bit. @p x must not be zero.
+inline unsigned msb (uint32_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return 31u - static_cast<unsigned>(__builtin_clz(x));
+#elif defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanReverse(&idx, x);
+  return static_cast<unsigned>(idx);
+#else
+  unsigned n = 0;
+  while (x >>= 1) { ++n; }
+  return n;
+#endif
+}
+
+
+/// @brief Index of the lowest set bit, usable in constant expressions.
+///        @p x must not be zero.
+constexpr unsigned ctz64 (uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+  unsigned n = 0;
+  while (!(x & 1u)) { x >>= 1; ++n; }
+  return n;
+#endif
+}
+
+/// @brief Index of the highest set bit, usable in constant expressions.
+///        @p x must not be zero.
+constexpr unsigned msb64 (uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(x));
+#else
+  unsigned n = 0;
+  while (x >>= 1) { ++n; }
+  return n;
+#endif
+}
+
+/// @brief Number of set bits, usable in constant expressions.
+constexpr unsigned popcount64 (uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return static_cast<unsigned>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+
+}  // namespace bits
+}  // namespace omtl
+
+#endif  // OMTL_UTILS_BITS_H
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef OMTL_UTILS_CPU_H
+#define OMTL_UTILS_CPU_H
+
+
+#if !defined(OMTL_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#  define OMTL_SIMD_X86 1
+#endif
+
+#ifdef OMTL_SIMD_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
+
+/// @def OMTL_TARGET(_Isa)
+///      Enables an instruction set for a single function so that it can be
+///      selected at runtime without compiling the whole TU for that ISA.
+#if defined(OMTL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#  define OMTL_TARGET(_Isa) __attribute__((target(_Isa)))
+#else
+#  define OMTL_TARGET(_Isa)
+#endif
+
+
+namespace omtl {
+namespace cpu {
+
+
+enum class feature {
+  sse2,
+  ssse3,
+  sse42,
+  avx2,
+
+  __SENTINEL__
+};
+
+
+namespace detail {
+
+inline unsigned detect (void) noexcept {
+  unsigned found = 0;
+#if defined(OMTL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))   { found |= 1u << static_cast<unsigned>(feature::sse2);  }
+  if (__builtin_cpu_supports("ssse3"))  { found |= 1u << static_cast<unsigned>(feature::ssse3); }
+  if (__builtin_cpu_supports("sse4.2")) { found |= 1u << static_cast<unsigned>(feature::sse42); }
+  if (__builtin_cpu_supports("avx2"))   { found |= 1u << static_cast<unsigned>(feature::avx2);  }
+#elif defined(OMTL_SIMD_X86) && defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, 1);
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  found |= 1u << static_cast<unsigned>(feature::sse2);
+  if (regs[2] & (1 << 9))  { found |= 1u << static_cast<unsigned>(feature::ssse3); }
+  if (regs[2] & (1 << 20)) { found |= 1u << static_cast<unsigned>(feature::sse42); }
+  __cpuidex(regs, 7, 0);
+  if (osxsave && (regs[1] & (1 << 5)) && (_xgetbv(0) & 0x6) == 0x6) {
+    found |= 1u << static_cast<unsigned>(feature::avx2);
+  }
+#endif
+  return found;
+}
+
+}  // namespace detail
+
+
+/// @brief True while the caller is being evaluated at compile time, where
+///        intrinsics are unavailable and constexpr code must take a scalar
+///        path. Compilers without the builtin always take the runtime path,
+///        so the scalar one is then only reached through constexpr calls
+///        that do not use SIMD to begin with.
+constexpr bool constant_evaluated (void) noexcept {
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+  return __builtin_is_constant_evaluated();
+#else
+  return false;
+#endif
+}
+
+
+/// @brief Checks whether the running CPU supports the instruction set.
+///        Detection runs once; subsequent calls are a single load.
+inline bool supports (feature f) noexcept {
+  static const unsigned found = detail::detect();
+  return (found >> static_cast<unsigned>(f)) & 1u;
+}
+
+
+}  // namespace cpu
+}  // namespace omtl
+
+#endif  // OMTL_UTILS_CPU_H
@@ -4,81 +4,195 @@
 #define OMTL_UTILS_FLAGS_H
 
 
-#include <bitset>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include <omtl/utils/bits.h>
 
 
 namespace omtl {
 
-template <typename T, typename UT = std::underlying_type_t<T>, size_t Bits = T::__SENTINEL__>
+
+namespace detail {
+
+/// @typedef Smallest unsigned integer with at least @p Bits bits.
+template <size_t Bits>
+using flags_storage = std::conditional_t<(Bits <=  8), uint8_t,
+                      std::conditional_t<(Bits <= 16), uint16_t,
+                      std::conditional_t<(Bits <= 32), uint32_t, uint64_t>>>;
+
+template <typename T, typename = void>
+struct is_flag_enum : std::false_type { };
+
+template <typename T>
+struct is_flag_enum<T, std::void_t<decltype(T::__SENTINEL__)>> : std::is_enum<T> { };
+
+}  // namespace detail
+
+
+/// @class Set of enumerators of @p T, which lists its values from 0 and
+///        ends with __SENTINEL__. Stored in the smallest integer that holds
+///        every enumerator, so a flags of up to 8 values is one byte, and
+///        every operation is constexpr. Iterating yields the set enumerators
+///        in increasing order.
+template <typename T, typename UT = std::underlying_type_t<T>, size_t Bits = static_cast<size_t>(T::__SENTINEL__)>
 class flags {
 public:
-  using utype     = UT;
-  using container = std::bitset<Bits>;
-  using reference = typename container::reference;
+  using utype        = UT;
+  using storage_type = detail::flags_storage<Bits>;
 
-  flags ()               = default;
-  flags (const flags &o) = default;
-  flags (T single) { set(single); }
+  static_assert(std::is_enum<T>::value, "flags hold enumerators");
+  static_assert(Bits <= 64, "flags hold at most 64 enumerators");
 
-  flags   &operator =  (const flags &o) { bitset = o.bitset; return *this; }
-  bool     operator == (const flags &o) const { return bitset == o.bitset; }
-  
-  operator bool () const { return bitset.any(); }
+  class iterator;
 
-  reference operator [] (T val)       { return bitset[static_cast<utype>(val)]; }
-  bool      operator [] (T val) const { return bitset[static_cast<utype>(val)]; }
+  constexpr flags (void) noexcept = default;
+  constexpr flags (T single) noexcept : _bits(bit(single)) { }
 
-  flags &operator |= (T val) {
-    bitset[static_cast<utype>(val)] = true;
-    return *this;
-  }
+  /// @brief Flags from their bit pattern, e.g. as loaded from storage.
+  static constexpr flags from_bits (storage_type b) noexcept { return flags(b & mask, 0); }
+  constexpr storage_type bits (void) const noexcept { return _bits; }
+
+  constexpr bool operator == (const flags &o) const noexcept { return _bits == o._bits; }
+  constexpr bool operator != (const flags &o) const noexcept { return _bits != o._bits; }
 
-  flags &operator &= (T val) {
-    bool tmp = bitset[static_cast<utype>(val)] ? true : false;
-    bitset.reset();
-    bitset[static_cast<utype>(val)] = tmp;
+  constexpr explicit operator bool (void) const noexcept { return _bits != 0; }
+
+  constexpr bool operator [] (T val) const noexcept { return test(val); }
+
+  constexpr flags &operator |= (const flags &o) noexcept { _bits |= o._bits; return *this; }
+  constexpr flags &operator &= (const flags &o) noexcept { _bits &= o._bits; return *this; }
+  constexpr flags &operator ^= (const flags &o) noexcept { _bits ^= o._bits; return *this; }
+
+  constexpr flags operator | (const flags &o) const noexcept { return flags(_bits | o._bits, 0); }
+  constexpr flags operator & (const flags &o) const noexcept { return flags(_bits & o._bits, 0); }
+  constexpr flags operator ^ (const flags &o) const noexcept { return flags(_bits ^ o._bits, 0); }
+  constexpr flags operator ~ (void)           const noexcept { return flags(~_bits & mask, 0); }
+
+  constexpr bool all  (void)  const noexcept { return _bits == mask; }
+  constexpr bool none (void)  const noexcept { return _bits == 0; }
+  constexpr bool any  (void)  const noexcept { return _bits != 0; }
+  constexpr bool test (T val) const noexcept { return (_bits & bit(val)) != 0; }
+
+  constexpr size_t size  (void) const noexcept { return Bits; }
+  constexpr size_t count (void) const noexcept { return bits::popcount64(_bits); }
+
+  constexpr flags &set   (void) noexcept { _bits = mask; return *this; }
+  constexpr flags &reset (void) noexcept { _bits = 0;    return *this; }
+  constexpr flags &flip  (void) noexcept { _bits = ~_bits & mask; return *this; }
+
+  constexpr flags &set (T val, bool value = true) noexcept {
+    _bits = value ? storage_type(_bits | bit(val)) : storage_type(_bits & ~bit(val));
     return *this;
   }
+  constexpr flags &reset (T val) noexcept { return set(val, false); }
+  constexpr flags &flip  (T val) noexcept { _bits ^= bit(val); return *this; }
+
+  constexpr iterator begin (void) const noexcept { return iterator(_bits); }
+  constexpr iterator end   (void) const noexcept { return iterator(0); }
 
-  flags operator ~ () {
-    flags cp(*this);
-    cp.bitset.flip();
-    return cp;
+  static constexpr storage_type bit (T val) noexcept {
+    return static_cast<storage_type>(storage_type(1) << static_cast<utype>(val));
   }
 
-  flags &operator &= (const flags &o) { bitset &= o.bitset; return *this; }
-  flags &operator |= (const flags &o) { bitset |= o.bitset; return *this; }
+private:
+  static constexpr storage_type mask = Bits == 64 ? storage_type(~uint64_t(0)) : storage_type((uint64_t(1) << Bits) - 1);
+
+  constexpr flags (storage_type b, int) noexcept : _bits(b) { }
+
+  storage_type _bits = 0;
+};
 
-  flags operator & (const flags &val) { return flags(*this) &= val; }
-  flags operator | (const flags &val) { return flags(*this) |= val; }
 
-  flags operator & (T val) { return flags(*this) &= val; }
-  flags operator | (T val) { return flags(*this) |= val; }
+/// @class Forward iterator over the set enumerators: each step clears the
+///        lowest remaining bit, each dereference counts trailing zeros.
+template <typename T, typename UT, size_t Bits>
+class flags<T, UT, Bits>::iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type        = T;
+  using difference_type   = std::ptrdiff_t;
+  using pointer           = const T *;
+  using reference         = T;
 
-  bool all  (void)  const { return bitset.all();  }
-  bool none (void)  const { return bitset.none(); }
-  bool any  (void)  const { return bitset.any();  }
-  bool test (T val) const { return bitset.test(static_cast<utype>(val)); }
+  constexpr iterator (void) noexcept = default;
+  constexpr explicit iterator (storage_type rest) noexcept : _rest(rest) { }
 
-  std::size_t size  (void) const { return bitset.size(); }
-  std::size_t count (void) const { return bitset.count(); }
+  constexpr T operator * (void) const noexcept { return static_cast<T>(bits::ctz64(_rest)); }
 
-  flags &set   () { bitset.set();   return *this; }
-  flags &reset () { bitset.reset(); return *this; }
-  flags &flip  () { bitset.flip();  return *this; }
+  constexpr iterator &operator ++ (void) noexcept { _rest &= storage_type(_rest - 1); return *this; }
+  constexpr iterator  operator ++ (int)  noexcept { iterator cp(*this); ++*this; return cp; }
 
-  flags &set   (T val, bool value = true) { bitset.set(static_cast<utype>(val), value); return *this; }
-  flags &reset (T val)                    { bitset.reset(static_cast<utype>(val));      return *this; }
-  flags &flip  (T val)                    { bitset.flip(static_cast<utype>(val));       return *this; }
+  constexpr bool operator == (const iterator &o) const noexcept { return _rest == o._rest; }
+  constexpr bool operator != (const iterator &o) const noexcept { return _rest != o._rest; }
 
 private:
-  container bitset;
+  storage_type _rest = 0;
 };
 
 
-template <typename T>
-typename std::enable_if_t<std::is_enum<T>::value, flags<T, std::underlying_type_t<T>>>
-operator | (const T &lhs, const T &rhs) { return flags<T, std::underlying_type_t<T>>() |= lhs |= rhs; }
+/// @brief Combines two enumerators of a flag enum (one ending with
+///        __SENTINEL__) into their flags.
+template <typename T, typename = std::enable_if_t<detail::is_flag_enum<T>::value>>
+constexpr flags<T> operator | (T lhs, T rhs) noexcept { return flags<T>(lhs) | rhs; }
+
+
+/// @class flags shared between threads. Every update is one lock-free
+///        read-modify-write of the same small integer as flags uses.
+template <typename T, typename UT = std::underlying_type_t<T>, size_t Bits = static_cast<size_t>(T::__SENTINEL__)>
+class atomic_flags {
+public:
+  using value_type   = flags<T, UT, Bits>;
+  using storage_type = typename value_type::storage_type;
+
+  static constexpr bool is_always_lock_free = std::atomic<storage_type>::is_always_lock_free;
+
+  constexpr atomic_flags (void) noexcept : _bits(0) { }
+  constexpr atomic_flags (value_type init) noexcept : _bits(init.bits()) { }
+
+  atomic_flags (const atomic_flags &) = delete;
+  atomic_flags &operator= (const atomic_flags &) = delete;
+
+  value_type load  (std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return value_type::from_bits(_bits.load(order));
+  }
+  void       store (value_type f, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    _bits.store(f.bits(), order);
+  }
+
+  /// @return The flags before the operation.
+  value_type fetch_or  (value_type f, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return value_type::from_bits(_bits.fetch_or(f.bits(), order));
+  }
+  value_type fetch_and (value_type f, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return value_type::from_bits(_bits.fetch_and(f.bits(), order));
+  }
+  value_type fetch_xor (value_type f, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return value_type::from_bits(_bits.fetch_xor(f.bits(), order));
+  }
+
+  bool test (T val, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return (_bits.load(order) & value_type::bit(val)) != 0;
+  }
+
+  /// @brief Sets @p val. @return Whether it was already set.
+  bool test_and_set (T val, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return (_bits.fetch_or(value_type::bit(val), order) & value_type::bit(val)) != 0;
+  }
+  /// @brief Clears @p val. @return Whether it was set.
+  bool test_and_reset (T val, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return (_bits.fetch_and(storage_type(~value_type::bit(val)), order) & value_type::bit(val)) != 0;
+  }
+
+  void set   (T val, std::memory_order order = std::memory_order_seq_cst) noexcept { test_and_set(val, order); }
+  void reset (T val, std::memory_order order = std::memory_order_seq_cst) noexcept { test_and_reset(val, order); }
+
+private:
+  std::atomic<storage_type> _bits;
+};
 
 
 }  // namespace omtl